@@ -8,59 +8,209 @@
  *************************************************************************/
 
 #include <chrono>
-#include <unordered_map>
+#include <concepts>
+#include <limits>
+#include <cstdint>
 
 #include "../parser.hpp"
+#include "../websocket/frame_parser.hpp"
+#include "../utils/session_table.hpp"
+#include "../utils/timer_wheel.hpp"
 
 
 namespace http_parser::acceptors {
 
+// the connection id by default: the parser's message object lives
+// as long as the parser, so its address identifies the connection.
+// the address can be reused by a next parser, so the I/O layer should
+// pass its own id with ws::for_connection.
+struct head_address {
+	template<typename Head>
+	std::uintptr_t operator()(const Head& head) const { return reinterpret_cast<std::uintptr_t>(&head); }
+};
+
 template<
         typename Head,
         typename DataContainer,
         typename Factory,
-        template<class,class> class Container = std::pmr::unordered_map
+        typename ContainerFactory = pmr_vector_factory,
+        typename ConnectionId = head_address,
+        typename Clock = std::chrono::steady_clock
         >
 struct ws : public http1_parser_chain_acceptor<Head, DataContainer> {
 	using base_t = http1_parser_chain_acceptor<Head, DataContainer>;
 	using head_t = base_t::head_t;
 	using data_view = base_t::data_view;
 	using handler_t = decltype(std::declval<Factory>()(std::declval<head_t>()));
+	using value_type = typename DataContainer::value_type;
+	using frame_parser_t = websocket::frame_parser<value_type>;
+	using connection_id_t = decltype(std::declval<ConnectionId>()(std::declval<const head_t&>()));
+	using duration = typename Clock::duration;
+	using time_point = typename Clock::time_point;
+
+	// handlers with on_frame receive decoded frames, others receive
+	// the raw data after the upgrade. the raw data is kept by the parser
+	// and passed again with the new data until on_message returns the
+	// count of processed bytes (void on_message keeps all the data).
+	constexpr static bool decode_frames = requires(handler_t& h, const websocket::frame_header& fh, std::span<value_type> p) {
+		h.on_frame(fh, p, true);
+	};
 
 	struct handler_info {
 		std::optional<handler_t> hndl;
-		std::chrono::steady_clock::time_point last_access = std::chrono::steady_clock::now();
+		std::uint64_t last_access = 0; // in ticks
+		frame_parser_t frames;
 	};
 
 	Factory handler_factory;
-	Container<const head_t*, handler_info> handlers;
+	ConnectionId connection_id;
+	session_table<connection_id_t, handler_info, ContainerFactory> handlers;
 
-	template<typename... Args>
-	ws(Factory&& f, Args... args)
+	ws(Factory&& f, ContainerFactory cf = ContainerFactory{}, ConnectionId id = ConnectionId{})
 	    : handler_factory(std::forward<Factory>(f))
-	    , handlers(std::forward<Args>(args)...)
+	    , connection_id(std::move(id))
+	    , handlers(cf)
+	    , timers(cf)
 	{
 	}
 
+	// sessions without messages for timeout are evicted by expire(),
+	// the timeout is rounded up to resolution
+	void idle_timeout(duration timeout, duration resolution = std::chrono::seconds(1))
+	{
+		tick = resolution;
+		idle_ticks = static_cast<std::uint64_t>((timeout + resolution - duration{1}) / resolution);
+		if(idle_ticks == 0) idle_ticks = 1;
+	}
+
+	// should be called periodically (from the event loop for example),
+	// it also updates the cached time used for messages.
+	// returns the count of evicted sessions.
+	std::size_t expire(time_point now = Clock::now())
+	{
+		std::size_t evicted = 0;
+		const auto now_tick = to_tick(now);
+		timers.advance(now_tick, [this,&evicted,now_tick](connection_id_t id) {
+			auto* info = handlers.find(id);
+			if(!info) return;
+			const std::uint64_t deadline = info->last_access + idle_ticks;
+			if(now_tick < deadline) timers.schedule(id, deadline);
+			else {
+				if constexpr (requires{ info->hndl->on_idle_timeout(); })
+					if(info->hndl) info->hndl->on_idle_timeout();
+				handlers.erase(id);
+				++evicted;
+			}
+		});
+		return evicted;
+	}
+
+	// text messages and close reasons with invalid utf-8 fail the
+	// session with close code 1007 (for sessions created after the call)
+	void utf8_validation(bool enable) { validate_utf8 = enable; }
+
+	// feeds the parser of a connection: the sessions are keyed by id
+	// inside feed instead of the ConnectionId of the head.
+	// the I/O layer calls it with its own id (a socket for example).
+	template<typename Feed>
+	decltype(auto) for_connection(connection_id_t id, Feed&& feed)
+	{
+		struct leave { std::optional<connection_id_t>& cur; ~leave(){ cur.reset(); } } guard{current_id};
+		current_id = id;
+		return std::forward<Feed>(feed)();
+	}
+
+	// removes the session (the connection is closed)
+	bool close(const head_t& head) { return handlers.erase(session_id(head)); }
+	bool close_connection(connection_id_t id) { return handlers.erase(id); }
+
+	std::optional<acceptor_key> selection_key() const override {
+		return acceptor_key{ .upgrade = "websocket", .method = methods::unknown, .path_prefix = {} };
+	}
+	// the same rule as the chain uses for the key
 	bool can_accept(const head_t& head) override {
-		using namespace std::literals;
 		auto val = head.headers().upgrade_header();
-		return val ? val->contains("websocket"sv) : false;
+		return val ? has_token(*val, "websocket") : false;
 	}
+	// without a chain the headers are checked here, once per message:
+	// the session exists only for accepted heads, so on_message looks
+	// up the session only
 	void on_head(const head_t& head) override {
+		if(can_accept(head)) on_selected_head(head);
+		else handlers.erase(session_id(head));
 	}
-	void on_message(const head_t& head, const data_view& body, std::size_t tail) override {
-		if(!can_accept(head)) return;
-		auto& hndl = handlers[&head];
+	// the chain has selected the acceptor by its key, nothing to check.
+	// each accepted head starts a new session, an existing one for
+	// the same id belongs to a previous connection.
+	void on_selected_head(const head_t& head) override {
+		const auto id = session_id(head);
+		auto [info, created] = handlers.try_emplace(id);
+		info->hndl.reset();
+		info->frames = validate_utf8
+		        ? frame_parser_t(true, std::numeric_limits<std::uint64_t>::max(), true)
+		        : frame_parser_t();
+		info->last_access = timers.now();
+		if(created && idle_ticks != 0) timers.schedule(id, timers.now() + idle_ticks);
+	}
+	std::size_t on_upgraded(const head_t& head, const data_view& data) override {
+		// no session (closed or not accepted): nobody needs the data
+		auto* info = handlers.find(session_id(head));
+		if(!info) return data.size();
+		auto& hndl = *info;
 		if(!hndl.hndl) hndl.hndl = create_new(head);
-		hndl.last_access = std::chrono::steady_clock::now();
+		hndl.last_access = timers.now();
 		assert(hndl.hndl.has_value());
-		hndl.hndl->on_message(body);
+		if constexpr (decode_frames) return decode(hndl, data);
+		else if constexpr (requires{ { hndl.hndl->on_message(data) } -> std::convertible_to<std::size_t>; })
+			return hndl.hndl->on_message(data);
+		else {
+			hndl.hndl->on_message(data);
+			return 0;
+		}
+	}
+	void on_message(const head_t& head, const data_view& body, std::size_t tail) override {
+		on_upgraded(head, body);
 	}
 	void on_error(const head_t& head, const data_view& body) override {
 	}
 private:
+	timer_wheel<connection_id_t, ContainerFactory> timers;
+	duration tick = std::chrono::seconds(1);
+	std::uint64_t idle_ticks = 0; // no eviction
+	bool validate_utf8 = false;
+	time_point start = Clock::now();
+	std::optional<connection_id_t> current_id;
+
+	connection_id_t session_id(const head_t& head)
+	{
+		return current_id ? *current_id : connection_id(head);
+	}
+
+	std::uint64_t to_tick(time_point tp) const
+	{
+		return tp <= start ? 0 : static_cast<std::uint64_t>((tp - start) / tick);
+	}
+
 	inline auto create_new(const head_t& head) { return handler_factory(head); }
+
+	// the data view covers the data not decoded yet, the frame parser
+	// keeps incomplete headers inside so all the data is processed.
+	// the bytes after the upgrade are owned by the session only, so
+	// they are unmasked in place. after an error the data is dropped.
+	std::size_t decode(handler_info& info, const data_view& data)
+	{
+		if(info.frames.failed() || data.size() == 0) return data.size();
+		std::span<value_type> fresh(const_cast<value_type*>(data.data()), data.size());
+		auto& hndl = *info.hndl;
+		info.frames(fresh, [&hndl](const websocket::frame_header& fh, std::span<value_type> payload, bool end) {
+			hndl.on_frame(fh, payload, end);
+		});
+		if(info.frames.failed()) {
+			if constexpr (requires{ hndl.on_frame_error(info.frames.close_code()); })
+				hndl.on_frame_error(info.frames.close_code());
+		}
+		return data.size();
+	}
 };
 
 } // namespace http_parser::acceptors
@@ -7,10 +7,15 @@
  * See accompanying file LICENSE (at the root of this repository)
  *************************************************************************/
 
+#include <span>
 #include <string>
 #include <charconv>
 #include <memory_resource>
 #include "uri_parser.hpp"
+#include "utils/methods.hpp"
+#include "utils/inner_static_vector.hpp"
+#include "utils/status_lines.hpp"
+#include "utils/date_header.hpp"
 
 namespace http_parser {
 
@@ -21,23 +26,21 @@ struct is_instance : std::false_type {};
 template<class T, template<class>class U>
 struct is_instance<U<T>, U> : std::true_type {};
 
-} // namespace details
+template<typename T>
+struct span_writer {
+	std::span<T> out;
+	std::size_t pos = 0;
 
-enum class methods { get, head, post, put, delete_method, connect, trace, patch };
-inline std::string_view to_string_view(methods m)
-{
-	using namespace std::literals;
-	if(m == methods::get) return "GET"sv;
-	if(m == methods::head) return "HEAD"sv;
-	if(m == methods::post) return "POST"sv;
-	if(m == methods::put) return "PUT"sv;
-	if(m == methods::delete_method) return "DELETE"sv;
-	if(m == methods::connect) return "CONNECT"sv;
-	if(m == methods::trace) return "TRACE"sv;
-	if(m == methods::patch) return "PATCH"sv;
-	assert(false);
-	return ""sv;
-}
+	void push_back(T v)
+	{
+		if(pos < out.size()) out[pos] = v;
+		++pos;
+	}
+
+	std::size_t size() const { return pos; }
+};
+
+} // namespace details
 
 template<typename StringView>
 struct uri {
@@ -53,6 +56,129 @@ struct header {
 };
 header(const char*, const char*) -> header<std::string_view>;
 
+struct output_buffer {
+	const void* data;
+	std::size_t size;
+};
+
+// result of gathered output: the generator owns only the framing (head,
+// headers, chunk size and so on), the body pieces point to caller memory.
+// use fill() to convert it to iovec (or any {ptr, len} aggregate) array.
+template<typename DataContainer, std::size_t MaxBuffers>
+class scattered_body {
+	struct piece {
+		const void* ext;
+		std::size_t pos;
+		std::size_t size;
+	};
+
+	DataContainer frame_;
+	inner_static_vector<piece, MaxBuffers> pieces;
+public:
+	explicit scattered_body(DataContainer f) : frame_(std::move(f)) {}
+
+	void add_frame(std::size_t pos, std::size_t size)
+	{
+		if(size != 0) pieces.emplace_back(nullptr, pos, size);
+	}
+
+	void add_external(const void* data, std::size_t size)
+	{
+		if(size != 0) pieces.emplace_back(data, 0, size);
+	}
+
+	const DataContainer& frame() const { return frame_; }
+
+	std::size_t size() const { return pieces.size(); }
+
+	output_buffer operator[](std::size_t ind) const
+	{
+		auto& p = pieces[ind];
+		if(p.ext) return output_buffer{ p.ext, p.size };
+		using value_type = typename DataContainer::value_type;
+		return output_buffer{ frame_.data() + p.pos, p.size * sizeof(value_type) };
+	}
+
+	std::size_t total_size() const
+	{
+		std::size_t ret = 0;
+		for(std::size_t i=0;i<size();++i) ret += (*this)[i].size;
+		return ret;
+	}
+
+	template<typename IoVec, std::size_t Extent>
+	std::size_t fill(std::span<IoVec, Extent> out) const
+	{
+		if(out.size() < size())
+			throw std::out_of_range("not enough space for gathered buffers");
+		for(std::size_t i=0;i<size();++i) {
+			auto buf = (*this)[i];
+			out[i] = IoVec{ const_cast<void*>(buf.data), buf.size };
+		}
+		return size();
+	}
+};
+
+// headers serialized once and shared between many responses.
+// the generator keeps only a pointer to the block, so the block
+// must outlive all generators it was attached to.
+template<typename DataContainer, typename StringView = std::string_view>
+class basic_header_block {
+	DataContainer data_;
+
+	void append(StringView str)
+	{
+		for(auto& c:str) data_.push_back((typename DataContainer::value_type)c);
+	}
+public:
+	explicit basic_header_block(DataContainer con) : data_(std::move(con)) {}
+
+	basic_header_block& add(StringView name, StringView val)
+	{
+		append(name);
+		data_.push_back((typename DataContainer::value_type)0x3A);
+		data_.push_back((typename DataContainer::value_type)0x20);
+		append(val);
+		data_.push_back((typename DataContainer::value_type)0x0D);
+		data_.push_back((typename DataContainer::value_type)0x0A);
+		return *this;
+	}
+
+	const DataContainer& data() const { return data_; }
+	std::size_t size() const { return data_.size(); }
+};
+
+// body stored in file: the region can be sent by sendfile or splice
+struct file_range {
+	int fd;
+	std::uint64_t offset;
+	std::size_t size;
+};
+
+// send head(), then file, then tail() (it's not empty for chunked messages)
+template<typename DataContainer>
+class file_output {
+	DataContainer frame_;
+	std::size_t head_size;
+
+	output_buffer part(std::size_t pos, std::size_t size) const
+	{
+		using value_type = typename DataContainer::value_type;
+		return output_buffer{ frame_.data() + pos, size * sizeof(value_type) };
+	}
+public:
+	file_output(DataContainer f, std::size_t head_size, file_range r)
+	    : frame_(std::move(f))
+	    , head_size(head_size)
+	    , file(r)
+	{}
+
+	file_range file;
+
+	output_buffer head() const { return part(0, head_size); }
+	output_buffer tail() const { return part(head_size, frame_.size() - head_size); }
+};
+
 template<
         typename DataContainerFactory
       , typename StringView = std::string_view
@@ -62,53 +188,64 @@ class basic_generator {
 	template<typename T>
 	struct cvt_int{ T value; int base = 10; };
 
+public:
+	using data_container_t = DataContainer;
+	using string_view_t = StringView;
+	using header_block = basic_header_block<DataContainer, StringView>;
+	constexpr static std::size_t max_header_blocks = 4;
+private:
 	enum class state_t { simple, chunked, chunked_progress };
 	DataContainerFactory dcf;
 	DataContainer headers;
 	DataContainer head;
+	inner_static_vector<const header_block*, max_header_blocks> blocks;
 	methods cur_method = methods::get;
+	int cur_status = 0;
 	mutable state_t cur_state = state_t::simple;
+	// the date is taken at serialization time, like header blocks
+	std::string_view (*date_provider)() = nullptr;
 
-	void append(DataContainer& con, StringView tail) const
+	template<typename Con>
+	void append(Con& con, StringView tail) const
 	{
 		for(auto& c:tail) append(con, (typename DataContainer::value_type)c);
 	}
 
-	template<std::size_t Cnt>
-	void append(DataContainer& con, char(&str)[Cnt]) const
+	template<typename Con, std::size_t Cnt>
+	void append(Con& con, char(&str)[Cnt]) const
 	{
 		for(std::size_t i=0;i<Cnt;++i)
 			append(con, DataContainer::value_type(str[i]));
 	}
 
-	template<typename Arg, typename... Args>
+	template<typename Con, typename Arg, typename... Args>
 	requires( sizeof...(Args) != 0 )
-	void append(DataContainer& con, Arg arg, Args... args) const
+	void append(Con& con, Arg arg, Args... args) const
 	{
 		append(con, arg);
 		if constexpr (sizeof...(Args) != 0) append(con, args...);
 	}
 
-	template<typename T>
+	template<typename Con, typename T>
 	requires(
 	        !std::is_pointer_v<T>
 	     && !std::is_same_v<std::decay_t<T>, DataContainer>
 	     && !details::is_instance<T, cvt_int>::value
 	        )
-	void append(DataContainer& con, T val) const
+	void append(Con& con, T val) const
 	{
 		con.push_back((typename DataContainer::value_type)val);
 	}
 
-	template<typename T>
+	template<typename Con, typename T>
 	requires( std::is_same_v<std::decay_t<T>, DataContainer> )
-	void append(DataContainer& con, const T& val) const
+	void append(Con& con, const T& val) const
 	{
 		for(auto& v:val) con.push_back(v);
 	}
 
-	template<typename T>
-	void append(DataContainer& con, cvt_int<T> num) const {
+	template<typename Con, typename T>
+	void append(Con& con, cvt_int<T> num) const {
 		std::array<char, std::numeric_limits<T>::digits10 + 1> str;
 		auto [ptr, ec] = std::to_chars(str.data(), str.data() + str.size(), num.value, num.base);
 		assert(ec == std::errc());
@@ -119,8 +256,7 @@ class basic_generator {
 	auto create_headers() const
 	{
 		DataContainer ret = dcf();
-		for(auto& h:head) ret.push_back(h);
-		for(auto& h:headers) ret.push_back(h);
+		append_headers(ret);
 		return ret;
 	}
 
@@ -132,15 +268,6 @@ class basic_generator {
 		return con;
 	}
 
-	template< typename Src >
-	DataContainer create_simple_body(Src cnt) const
-	{
-		DataContainer ret = create_headers();
-		if(cnt.size() == 0) append(ret, "\r\n");
-		else append(set_content_length(ret, cnt.size()), cnt);
-		return ret;
-	}
-
 	template<typename Con>
 	Con& create_chunked_body(Con& con, std::size_t sz) const
 	{
@@ -152,33 +279,66 @@ class basic_generator {
 		return con;
 	}
 
+	template<typename Con>
+	void append_headers(Con& con) const
+	{
+		for(auto& h:head) con.push_back(h);
+		if(date_provider) {
+			auto val = date_provider();
+			append(con, "Date: ", StringView(val.data(), val.size()), "\r\n");
+		}
+		for(std::size_t i=0;i<blocks.size();++i)
+			for(auto& h:blocks[i]->data()) con.push_back(h);
+		for(auto& h:headers) con.push_back(h);
+	}
+
+	// writes all the message framing into con and calls write_cnt(con)
+	// in place where sz bytes of body should be. the state is passed
+	// explicitly so the caller can decide to commit it or not.
+	template<typename Con, typename Writer>
+	void write_message(Con& con, std::size_t sz, state_t& st, Writer&& write_cnt) const
+	{
+		if(st != state_t::chunked_progress) append_headers(con);
+		if(st == state_t::simple) {
+			if(sz == 0) append(con, "\r\n");
+			else write_cnt(set_content_length(con, sz));
+			return;
+		}
+		const bool first = st == state_t::chunked;
+		st = state_t::chunked_progress;
+		if(first) append(con, "\r\n");
+		if(first && sz == 0) return;
+		append(con, cvt_int{ sz, 16 }, "\r\n");
+		write_cnt(con);
+		append(con, "\r\n");
+	}
+
 	template< typename Src >
-	DataContainer create_chunked_body(Src cnt) const
+	DataContainer create_body(const Src& cnt) const
 	{
 		DataContainer ret = dcf();
-		if(cnt.size() == 0) append(ret, "0\r\n");
-		else append(ret, cvt_int{ cnt.size(), 16 }, "\r\n", cnt);
-		append(ret, "\r\n");
+		write_message(ret, cnt.size(), cur_state, [this,&cnt](auto& con){ append(con, cnt); });
 		return ret;
 	}
+	// framing for body of size sz which will be written by someone else,
+	// split is the body position in the frame
+	DataContainer create_frame(std::size_t sz, std::size_t& split) const
+	{
+		split = 0;
+		DataContainer frame = dcf();
+		write_message(frame, sz, cur_state, [&split](auto& con){ split = con.size(); });
+		if(split == 0) split = frame.size();
+		return frame;
+	}
 
 	template< typename Src >
-	DataContainer create_body(Src cnt) const
+	std::size_t write_to(std::span<typename DataContainer::value_type> out, const Src& cnt) const
 	{
-		if(cur_state == state_t::simple)
-			return create_simple_body(std::forward<Src>(cnt));
-		if(cur_state == state_t::chunked) {
-			auto ret = create_headers();
-			if(cnt.size() !=0 )
-				append(ret, "\r\n", create_chunked_body(std::forward<Src>(cnt)));
-			else append(ret, "\r\n");
-			cur_state = state_t::chunked_progress;
-			return ret;
-		}
-		if(cur_state == state_t::chunked_progress)
-			return create_chunked_body(std::forward<Src>(cnt));
-		assert(false);
-		throw std::logic_error("inner error (not all state supported)");
+		auto st = cur_state;
+		details::span_writer<typename DataContainer::value_type> writer{ out };
+		write_message(writer, cnt.size(), st, [this,&cnt](auto& con){ append(con, cnt); });
+		if(writer.size() <= out.size()) cur_state = st;
+		return writer.size();
 	}
 public:
 	basic_generator() requires std::is_default_constructible_v<DataContainerFactory>
@@ -190,6 +350,20 @@ public:
 	{
 	}
 
+	// prepares the generator for next message, the containers
+	// are cleared but keep its capacity
+	basic_generator& reset()
+	{
+		head.clear();
+		headers.clear();
+		blocks.clear();
+		date_provider = nullptr;
+		cur_method = methods::get;
+		cur_status = 0;
+		cur_state = state_t::simple;
+		return *this;
+	}
+
 	basic_generator& method(methods m)
 	{
 		cur_method = m;
@@ -201,12 +375,28 @@ public:
 		if(code < 100 || 999 < code)
 			throw std::runtime_error("this code are not allowed in response");
 		append(head, "HTTP/1.1 ", cvt_int{code}, ' ', r, 0x0d, 0x0a);
+		cur_status = code;
+		return *this;
+	}
+
+	// status line with standard reason, copied from precomputed table
+	basic_generator& response(int code)
+	{
+		if(code < min_status_code || max_status_code < code)
+			throw std::runtime_error("this code are not allowed in response");
+		const status_line& line = find_status_line(code);
+		const std::size_t pos = head.size();
+		head.resize(pos + line.size);
+		for(std::size_t i=0;i<line.size;++i)
+			head[pos + i] = (typename DataContainer::value_type)line.data[i];
+		cur_status = code;
 		return *this;
 	}
 
 	basic_generator& uri(StringView u)
 	{
 		head.clear();
+		cur_status = 0;
 		basic_uri_parser<StringView> prs(u);
 		append(head, to_string_view(cur_method));
 		append(head, (typename DataContainer::value_type)0x20); // space
@@ -223,21 +413,110 @@ public:
 		return *this;
 	}
 
+	// adds the Date header, its value is taken from DateProvider each
+	// time the message is serialized, so repeated calls add nothing
+	template<typename DateProvider = cached_date<>>
+	basic_generator& date()
+	{
+		date_provider = &DateProvider::now;
+		return *this;
+	}
+
+	header_block make_header_block() const
+	{
+		return header_block(dcf());
+	}
+
+	basic_generator& headers_block(const header_block& block)
+	{
+		blocks.emplace_back(&block);
+		return *this;
+	}
+
 	DataContainer body(StringView cnt) const
 	{
 		return create_body(cnt);
 	}
 
-	DataContainer body(DataContainer cnt) const
+	DataContainer body(const DataContainer& cnt) const
 	{
 		return create_body(cnt);
 	}
 
+	// serializes the message into out without any allocation. returns
+	// the size required for it: if it is bigger then out.size() nothing
+	// was written (the generator state is not changed) and the call
+	// should be repeated with bigger buffer.
+	std::size_t body_to(std::span<typename DataContainer::value_type> out, StringView cnt) const
+	{
+		return write_to(out, cnt);
+	}
+
+	std::size_t body_to(std::span<typename DataContainer::value_type> out, const DataContainer& cnt) const
+	{
+		return write_to(out, cnt);
+	}
+
+	// serializes the message to the end of out
+	DataContainer& append_body(DataContainer& out, StringView cnt) const
+	{
+		write_message(out, cnt.size(), cur_state, [this,&cnt](auto& con){ append(con, cnt); });
+		return out;
+	}
+
+	DataContainer& append_body(DataContainer& out, const DataContainer& cnt) const
+	{
+		write_message(out, cnt.size(), cur_state, [this,&cnt](auto& con){ append(con, cnt); });
+		return out;
+	}
+
+	template<std::size_t MaxBuffers = 16>
+	scattered_body<DataContainer, MaxBuffers> gather_body(StringView cnt) const
+	{
+		return gather_body<MaxBuffers>(std::span<const StringView>(&cnt, 1));
+	}
+
+	template<std::size_t MaxBuffers = 16>
+	scattered_body<DataContainer, MaxBuffers> gather_body(std::span<const StringView> segments) const
+	{
+		using char_type = typename StringView::value_type;
+		std::size_t total = 0;
+		for(auto& s:segments) total += s.size();
+
+		std::size_t split = 0;
+		scattered_body<DataContainer, MaxBuffers> ret(create_frame(total, split));
+		ret.add_frame(0, split);
+		for(auto& s:segments) ret.add_external(s.data(), s.size() * sizeof(char_type));
+		ret.add_frame(split, ret.frame().size() - split);
+		return ret;
+	}
+
+	// only the framing is generated, the file content should be sent
+	// by the i/o layer between head and tail
+	file_output<DataContainer> body(const file_range& file) const
+	{
+		std::size_t split = 0;
+		auto frame = create_frame(file.size, split);
+		return file_output<DataContainer>(std::move(frame), split, file);
+	}
+
+	// code of the response status line, 0 for requests
+	int status_code() const
+	{
+		return cur_status;
+	}
+
 	bool chunked() const
 	{
 		return cur_state == state_t::chunked || cur_state == state_t::chunked_progress;
 	}
 
+	// the head is already written and chunks are being sent
+	bool chunked_in_progress() const
+	{
+		return cur_state == state_t::chunked_progress;
+	}
+
 	basic_generator& make_chunked()
 	{
 		if(!chunked())
@@ -269,4 +548,11 @@ operator << (basic_generator<C,S>& left, const header<S>& right)
 	return left.header(right.n, right.v);
 }
 
+template<typename C, typename S>
+inline basic_generator<C,S>&
+operator << (basic_generator<C,S>& left, const typename basic_generator<C,S>::header_block& right)
+{
+	return left.headers_block(right);
+}
+
 } // namespace http_parser
@@ -0,0 +1,89 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <chrono>
+#include <optional>
+
+#include "../generator.hpp"
+
+namespace http_parser::generators {
+
+// buffers small fragments and emits them as a single chunk when
+// the buffer reaches the limit or the deadline is expired.
+// the deadline is checked on write() and expired(), there is no timer
+// inside: call expired() from event loop and flush() if it's true.
+template<typename Generator, typename Clock = std::chrono::steady_clock>
+class chunk_coalescer {
+public:
+	using data_container_t = typename Generator::data_container_t;
+	using string_view_t = typename Generator::string_view_t;
+	using time_point = typename Clock::time_point;
+	using duration = typename Clock::duration;
+private:
+	Generator* gen;
+	data_container_t pending;
+	std::size_t limit;
+	duration deadline;
+	time_point first_fragment;
+public:
+	chunk_coalescer(Generator& g, data_container_t buf, std::size_t limit, duration deadline = duration::max())
+	    : gen(&g)
+	    , pending(std::move(buf))
+	    , limit(limit)
+	    , deadline(deadline)
+	{
+		pending.clear();
+		if(!gen->chunked()) gen->make_chunked();
+	}
+
+	std::optional<data_container_t> write(string_view_t fragment)
+	{
+		if(fragment.empty()) return std::nullopt;
+		// big fragments are not buffered: the pending data goes first
+		// and the fragment is serialized right after it
+		if(limit <= fragment.size()) {
+			auto ret = flush();
+			if(!ret) return gen->body(fragment);
+			gen->append_body(*ret, fragment);
+			return ret;
+		}
+		if(pending.empty()) first_fragment = Clock::now();
+		for(auto& c:fragment) pending.push_back((typename data_container_t::value_type)c);
+		if(limit <= pending.size() || expired(Clock::now())) return flush();
+		return std::nullopt;
+	}
+
+	bool expired(time_point now) const
+	{
+		return !pending.empty() && deadline <= now - first_fragment;
+	}
+
+	std::optional<data_container_t> flush()
+	{
+		if(pending.empty()) return std::nullopt;
+		auto ret = gen->body(pending);
+		pending.clear();
+		return ret;
+	}
+
+	// flushes buffered data and writes the last chunk
+	data_container_t finish()
+	{
+		auto ret = flush();
+		if(!ret && !gen->chunked_in_progress()) ret = gen->body(string_view_t{});
+		auto last = gen->body(string_view_t{});
+		if(!ret) return last;
+		for(auto& c:last) ret->push_back(c);
+		return std::move(*ret);
+	}
+
+	std::size_t buffered() const { return pending.size(); }
+};
+
+} // namespace http_parser::generators
@@ -0,0 +1,71 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include "../generator.hpp"
+
+namespace http_parser::generators {
+
+// collects several complete responses (for pipelined requests) one
+// after another in single buffer. clear() keeps the capacity, so the
+// same batch can be used for whole connection.
+template<typename DataContainer>
+class response_batch {
+	DataContainer data_;
+	std::size_t count_ = 0;
+public:
+	explicit response_batch(DataContainer con, std::size_t reserve = 0)
+	    : data_(std::move(con))
+	{
+		data_.clear();
+		if(reserve != 0) data_.reserve(reserve);
+	}
+
+	// an empty response gets Content-Length: 0 (if its status allows
+	// a body), otherwise the client reads it until the connection is
+	// closed and takes the next responses of the batch as its body
+	template<typename Generator, typename Body>
+	response_batch& add(const Generator& gen, const Body& body)
+	{
+		gen.append_body(data_, body);
+		if(body.size() == 0 && !gen.chunked() && body_allowed(gen.status_code())) {
+			using namespace std::literals;
+			data_.resize(data_.size() - 2);
+			for(auto c:"Content-Length: 0\r\n\r\n"sv)
+				data_.push_back((typename DataContainer::value_type)c);
+		}
+		++count_;
+		return *this;
+	}
+
+	// adds already serialized response (static_response for example)
+	template<typename Raw>
+	requires requires(const Raw& r){ r.data(); r.size(); }
+	response_batch& add(const Raw& raw)
+	{
+		for(std::size_t i=0;i<raw.size();++i)
+			data_.push_back((typename DataContainer::value_type)raw.data()[i]);
+		++count_;
+		return *this;
+	}
+
+	void reserve(std::size_t size) { data_.reserve(size); }
+
+	void clear()
+	{
+		data_.clear();
+		count_ = 0;
+	}
+
+	const DataContainer& data() const { return data_; }
+	std::size_t size() const { return data_.size(); }
+	std::size_t count() const { return count_; }
+	bool empty() const { return count_ == 0; }
+};
+
+} // namespace http_parser::generators
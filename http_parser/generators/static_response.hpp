@@ -0,0 +1,73 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include "../generator.hpp"
+#include "../utils/fixed_string.hpp"
+#include "../utils/status_lines.hpp"
+
+namespace http_parser::generators {
+
+template<std::size_t N>
+struct static_response_data {
+	std::array<char, N> bytes;
+
+	constexpr const char* data() const { return bytes.data(); }
+	constexpr std::size_t size() const { return N; }
+	constexpr std::string_view view() const { return std::string_view(bytes.data(), N); }
+	output_buffer buffer() const { return output_buffer{ bytes.data(), N }; }
+};
+
+namespace details {
+
+template<int Code, fixed_string Body, fixed_string... Headers>
+constexpr void write_static_response(auto&& put)
+{
+	auto put_str = [&put](std::string_view str){ for(char c:str) put(c); };
+	put_str(find_status_line(Code).view());
+	[[maybe_unused]] auto put_header = [&](std::string_view h){ put_str(h); put('\r'); put('\n'); };
+	(put_header(Headers.view()), ...);
+	if constexpr (body_allowed(Code)) {
+		put_str("Content-Length: ");
+		std::array<char, 20> digits{};
+		std::size_t cnt = 0, len = Body.size();
+		do { digits[cnt++] = '0' + len % 10; len /= 10; } while(len != 0);
+		while(cnt != 0) put(digits[--cnt]);
+		put('\r');
+		put('\n');
+	}
+	put('\r');
+	put('\n');
+	if constexpr (body_allowed(Code)) put_str(Body.view());
+}
+
+template<int Code, fixed_string Body, fixed_string... Headers>
+constexpr auto build_static_response()
+{
+	static_assert(min_status_code <= Code && Code <= max_status_code, "wrong status code");
+	static_assert(body_allowed(Code) || Body.size() == 0, "this status cannot contain body");
+	constexpr std::size_t size = []{
+		std::size_t ret = 0;
+		write_static_response<Code, Body, Headers...>([&ret](char){ ++ret; });
+		return ret;
+	}();
+	static_response_data<size> ret{};
+	std::size_t pos = 0;
+	write_static_response<Code, Body, Headers...>([&ret,&pos](char c){ ret.bytes[pos++] = c; });
+	return ret;
+}
+
+} // namespace details
+
+// whole response built at compile time. headers are passed in
+// "Name: value" form, Content-Length is added automatically.
+template<int Code, fixed_string Body = "", fixed_string... Headers>
+inline constexpr auto static_response = details::build_static_response<Code, Body, Headers...>();
+
+} // namespace http_parser::generators
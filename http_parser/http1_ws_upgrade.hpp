@@ -7,13 +7,150 @@
  * See accompanying file LICENSE (at the root of this repository)
  *************************************************************************/
 
+#include <span>
+#include <array>
 #include "parser.hpp"
+#include "generator.hpp"
+#include "websocket/handshake.hpp"
 
 namespace http_parser {
 
-template<typename Head, typename DataContainer>
-struct http1_ws_acceptor : public http1_parser_acceptor<Head, DataContainer> {
+namespace websocket {
+
+enum class handshake_error {
+	none,
+	wrong_method,
+	wrong_header_name,
+	no_host,
+	no_upgrade,
+	no_connection_upgrade,
+	wrong_version,
+	wrong_key
 };
 
+// checks the opening handshake request (rfc 6455 section 4.2.1)
+template<typename Head>
+handshake_error validate_handshake(const Head& head)
+{
+	if(head.head().method_code() != methods::get) return handshake_error::wrong_method;
+	if(!head.headers().ascii_names()) return handshake_error::wrong_header_name;
+	if(!head.find_header("Host")) return handshake_error::no_host;
+	auto upgrade = head.find_header("Upgrade");
+	if(!upgrade || !has_token(*upgrade, "websocket")) return handshake_error::no_upgrade;
+	auto connection = head.find_header("Connection");
+	if(!connection || !has_token(*connection, "upgrade")) return handshake_error::no_connection_upgrade;
+	auto version = head.find_header("Sec-WebSocket-Version");
+	if(!version || !(*version == supported_version)) return handshake_error::wrong_version;
+	auto key = head.find_header("Sec-WebSocket-Key");
+	if(!key || !valid_client_key(*key)) return handshake_error::wrong_key;
+	return handshake_error::none;
+}
+
+// writes the response to the handshake into out: 101 if it is valid,
+// 426 for unsupported version and 400 for other errors. the errors
+// have empty body and close the connection.
+// returns the required size, nothing is written if out is too small
+// (see basic_generator::body_to). gen is reset before use, so it can
+// be reused to avoid allocations.
+template<typename Generator, typename Head>
+std::size_t handshake_response(
+          Generator& gen
+        , const Head& head
+        , std::span<typename Generator::data_container_t::value_type> out
+        , handshake_error& err)
+{
+	using string_view_t = typename Generator::string_view_t;
+	gen.reset();
+	err = validate_handshake(head);
+	if(err == handshake_error::none) {
+		auto key = make_accept_key(*head.find_header("Sec-WebSocket-Key"));
+		gen.response(101)
+		   .header("Upgrade", "websocket")
+		   .header("Connection", "Upgrade")
+		   .header("Sec-WebSocket-Accept", string_view_t(key.value.data(), key.value.size()));
+		return gen.body_to(out, string_view_t{});
+	}
+	gen.response(err == handshake_error::wrong_version ? 426 : 400);
+	if(err == handshake_error::wrong_version)
+		gen.header("Sec-WebSocket-Version", string_view_t(supported_version.data(), supported_version.size()));
+	gen.header("Content-Length", "0").header("Connection", "close");
+	return gen.body_to(out, string_view_t{});
+}
+
+} // namespace websocket
+
+// performs the websocket opening handshake: the response is built on
+// the stack by the generator, which is reused between handshakes so
+// there are no allocations per handshake after the first one.
+// writer(head, std::span<const char> response, bool accepted) sends it.
+// the messages of accepted connections are passed to the frames
+// acceptor (acceptors::ws for example), it should not be added to the
+// chain itself: both select the "websocket" upgrade. without it the
+// data after the upgrade is dropped.
+template<
+        typename Head,
+        typename DataContainer,
+        typename Writer,
+        typename Generator = basic_generator<pmr_string_factory, std::string_view>
+        >
+struct http1_ws_acceptor : public chainable_acceptor<Head, DataContainer> {
+	using base_t = chainable_acceptor<Head, DataContainer>;
+	using head_t = base_t::head_t;
+	using data_view = base_t::data_view;
+	using frames_acceptor_t = chainable_acceptor<Head, DataContainer>;
+	constexpr static std::size_t max_response_size = 256;
+
+	Writer writer;
+
+	explicit http1_ws_acceptor(Writer w, Generator g = Generator{})
+	    : http1_ws_acceptor(std::move(w), nullptr, std::move(g))
+	{
+	}
+
+	http1_ws_acceptor(Writer w, frames_acceptor_t* frames, Generator g = Generator{})
+	    : writer(std::move(w))
+	    , frames(frames)
+	    , gen(std::move(g))
+	{
+	}
+
+	std::optional<acceptor_key> selection_key() const override
+	{
+		return acceptor_key{ .upgrade = "websocket", .method = methods::unknown, .path_prefix = {} };
+	}
+
+	void on_head(const head_t& head) override
+	{
+		std::array<typename Generator::data_container_t::value_type, max_response_size> buf;
+		websocket::handshake_error err;
+		const std::size_t size = websocket::handshake_response(gen, head, buf, err);
+		if(buf.size() < size) throw std::out_of_range("websocket handshake response is too big");
+		const bool ok = err == websocket::handshake_error::none;
+		accepted.bind(head, [ok](const head_t&){ return ok; });
+		writer(head, std::span<const char>((const char*)buf.data(), size), ok);
+		if(ok && frames) frames->on_selected_head(head);
+	}
+	void on_message(const head_t& head, const data_view& body, std::size_t tail) override
+	{
+		if(frames && is_accepted(head)) frames->on_message(head, body, tail);
+	}
+	void on_error(const head_t& head, const data_view& body) override
+	{
+		if(frames && is_accepted(head)) frames->on_error(head, body);
+	}
+	std::size_t on_upgraded(const head_t& head, const data_view& data) override
+	{
+		return frames && is_accepted(head) ? frames->on_upgraded(head, data) : data.size();
+	}
+private:
+	frames_acceptor_t* frames;
+	Generator gen;
+	chain_acceptor_details::binding_table<head_t, bool> accepted;
+
+	bool is_accepted(const head_t& head) const
+	{
+		return accepted.bound(head, [](const head_t& h){ return websocket::validate_handshake(h) == websocket::handshake_error::none; });
+	}
+};
 
 } // namespace http_parser
@@ -12,6 +12,9 @@
 #include "utils/cvt.hpp"
 #include "utils/pos_string_view.hpp"
 #include "utils/factories.hpp"
+#include "utils/methods.hpp"
+#include "utils/utf8.hpp"
+#include "utils/tokens.hpp"
 
 namespace http_parser {
 
@@ -81,6 +84,14 @@ public:
 		return pos == headers_.end() ? std::nullopt : std::make_optional(pos->value);
 	}
 
+	// header names are tokens (rfc 9110 section 5.1), so any non ascii
+	// byte in them means a broken or malicious message
+	bool ascii_names() const
+	{
+		for(auto& h:headers_) if(!is_ascii(h.name.data(), h.name.size())) return false;
+		return true;
+	}
+
 	std::optional<std::size_t> content_size() const
 	{
 		auto header = find_header("Content-Length");
@@ -97,12 +108,18 @@ public:
 
 	bool body_exists() const
 	{
-		using namespace std::literals;
 		auto size = content_size();
 		return
 		        (size && *size != 0)
 		     || is_chunked()
-		     || (upgrade_header().has_value() && find_header("Connection") == "Upgrade"sv);
+		     || (upgrade_header().has_value() && is_connection_upgrade());
+	}
+
+	// "Connection: keep-alive, Upgrade" is an upgrade too
+	bool is_connection_upgrade() const
+	{
+		auto header = find_header("Connection");
+		return header && has_token(*header, "upgrade");
 	}
 
 	auto upgrade_header() const
@@ -123,6 +140,7 @@ private:
 	container_view method_;
 	container_view url_src_;
 	mutable url_view url_;
+	methods method_code_ = methods::unknown;
 public:
 	req_head_message(const DataContainer* d)
 	    : data_(d)
@@ -141,9 +159,11 @@ public:
 	}
 
 	container_view method() const { return method_; }
+	methods method_code() const { return method_code_; }
 	auto& method(std::size_t pos, std::size_t size)
 	{
 		method_.assign(pos, size);
+		method_code_ = classify_method(method_);
 		return *this;
 	}
 
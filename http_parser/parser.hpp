@@ -7,7 +7,14 @@
  * See accompanying file LICENSE (at the root of this repository)
  *************************************************************************/
 
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <tuple>
+#include <utility>
 #include <variant>
+#include <optional>
+#include <string_view>
 #include <type_traits>
 #include "message.hpp"
 #include "utils/headers_parser.hpp"
@@ -27,6 +34,23 @@ struct http1_parser_acceptor {
 	virtual void on_head(const head_t& head) {}
 	virtual void on_message(const head_t& head, const data_view& body, std::size_t tail) {}
 	virtual void on_error(const head_t& head, const data_view& body) {}
+	// data received after an upgrade, returns how many bytes of it are
+	// processed: the parser drops them, the rest is passed again with
+	// the next data. by default all the data is kept.
+	virtual std::size_t on_upgraded(const head_t& head, const data_view& data)
+	{
+		on_message(head, data, 0);
+		return 0;
+	}
+};
+
+// static description of messages an acceptor takes: the chain indexes
+// acceptors by the keys and doesn't call can_accept for them.
+// empty field matches any message. the views must outlive the chain.
+struct acceptor_key {
+	std::string_view upgrade; // token in the Upgrade header
+	methods method = methods::unknown;
+	std::string_view path_prefix;
 };
 
 template<typename Head, typename DataContainer>
@@ -34,15 +58,151 @@ struct chainable_acceptor : public http1_parser_acceptor<Head, DataContainer> {
 	using head_t = http1_parser_acceptor<Head, DataContainer>::head_t;
 	using data_view = http1_parser_acceptor<Head, DataContainer>::data_view;
 	virtual bool can_accept(const head_t& head) { return true; }
+	virtual std::optional<acceptor_key> selection_key() const { return std::nullopt; }
+	// called by a chain instead of on_head when it selected the acceptor
+	// for the head: the key or can_accept is already checked
+	virtual void on_selected_head(const head_t& head) { this->on_head(head); }
 };
 
+namespace chain_acceptor_details {
+
+// remembers the acceptor selected for a message head. the heads are
+// distinguished by address, a collision only costs a new selection.
+template<typename Head, typename Value>
+class binding_table {
+	struct binding {
+		const Head* head = nullptr;
+		Value value{};
+	};
+	constexpr static std::size_t bindings_count = 64;
+	std::array<binding, bindings_count> bindings{};
+
+	static std::size_t index(const Head& head)
+	{
+		auto addr = reinterpret_cast<std::uintptr_t>(&head);
+		return (addr ^ (addr >> 7) ^ (addr >> 13)) % bindings_count;
+	}
+public:
+	template<typename Select>
+	Value bind(const Head& head, Select&& select)
+	{
+		auto& b = bindings[index(head)];
+		b.head = &head;
+		b.value = select(head);
+		return b.value;
+	}
+
+	template<typename Select>
+	Value bound(const Head& head, Select&& select) const
+	{
+		auto& b = bindings[index(head)];
+		return b.head == &head ? b.value : select(head);
+	}
+
+	void clear()
+	{
+		bindings.fill(binding{});
+	}
+};
+
+} // namespace chain_acceptor_details
+
+// selects an acceptor for a message from the registered ones.
+// the chain is not thread safe: on_head stores the selected acceptor
+// in the chain, so the chain (with all its parsers) must be used from
+// one thread. create a chain per thread (or per parser) otherwise.
 template<typename Head, typename DataContainer, template<class> class Container = std::pmr::vector>
 struct http1_parser_chain_acceptor : public chainable_acceptor<Head, DataContainer> {
 	using base_acc_type = chainable_acceptor<Head, DataContainer>;
 	using head_t = base_acc_type::head_t;
 	using data_view = base_acc_type::data_view;
 private:
+	struct keyed {
+		acceptor_key key;
+		std::uint32_t order;
+	};
+	// methods_count is the slot for keys without method
+	constexpr static std::size_t any_method = methods_count;
+	constexpr static std::uint32_t none = static_cast<std::uint32_t>(-1);
+
 	Container<std::shared_ptr<base_acc_type>> queue;
+	// the acceptor is selected once per message in on_head and reused
+	// for the rest callbacks of the message. the heads are distinguished
+	// by address, so one chain can serve several parsers of one thread.
+	chain_acceptor_details::binding_table<head_t, base_acc_type*> bindings;
+	std::array<Container<keyed>, methods_count + 1> by_method{};
+	Container<std::uint32_t> unkeyed{};
+
+	void index(const base_acc_type& acc)
+	{
+		const auto order = static_cast<std::uint32_t>(queue.size() - 1);
+		if(auto key = acc.selection_key(); key) {
+			std::size_t slot = key->method == methods::unknown ? any_method : static_cast<std::size_t>(key->method);
+			by_method[slot].push_back(keyed{*key, order});
+		}
+		else unkeyed.push_back(order);
+		bindings.clear();
+	}
+
+	static bool match(const acceptor_key& key, const head_t& head)
+	{
+		if(!key.path_prefix.empty()) {
+			if constexpr (requires{ head.head().url().path(); }) {
+				if(!std::string_view(head.head().url().path()).starts_with(key.path_prefix)) return false;
+			}
+			else return false;
+		}
+		if(!key.upgrade.empty()) {
+			auto val = head.headers().upgrade_header();
+			if(!val || !has_token(*val, key.upgrade)) return false;
+		}
+		return true;
+	}
+
+	// the first registered acceptor wins: the keyed acceptors for the
+	// method, for any method and the rest are merged by the order
+	std::uint32_t select(const head_t& head) const
+	{
+		methods m = methods::unknown;
+		if constexpr (requires{ head.head().method_code(); }) m = head.head().method_code();
+		static const Container<keyed> empty_list{};
+		const auto& for_method = m == methods::unknown ? empty_list : by_method[static_cast<std::size_t>(m)];
+		const auto& for_any = by_method[any_method];
+
+		std::size_t mi = 0, ai = 0, ui = 0;
+		for(;;) {
+			std::uint32_t mo = mi < for_method.size() ? for_method[mi].order : none;
+			std::uint32_t ao = ai < for_any.size() ? for_any[ai].order : none;
+			std::uint32_t uo = ui < unkeyed.size() ? unkeyed[ui] : none;
+			if(mo < ao && mo < uo) {
+				if(match(for_method[mi].key, head)) return mo;
+				++mi;
+			} else if(ao < uo) {
+				if(match(for_any[ai].key, head)) return ao;
+				++ai;
+			} else if(uo != none) {
+				if(queue[uo]->can_accept(head)) return uo;
+				++ui;
+			}
+			else return none;
+		}
+	}
+
+	base_acc_type* find_acceptor(const head_t& head) const
+	{
+		auto ind = select(head);
+		return ind == none ? nullptr : queue[ind].get();
+	}
+
+	base_acc_type* bind(const head_t& head)
+	{
+		return bindings.bind(head, [this](const head_t& h){ return find_acceptor(h); });
+	}
+
+	base_acc_type* bound(const head_t& head) const
+	{
+		return bindings.bound(head, [this](const head_t& h){ return find_acceptor(h); });
+	}
 public:
 	template<typename... T>
 	http1_parser_chain_acceptor(T... args)
@@ -51,6 +211,7 @@ public:
 
 	void add(std::shared_ptr<base_acc_type> acc) {
 		queue.push_back(acc);
+		index(*acc);
 	}
 
 	template<typename T>
@@ -60,13 +221,18 @@ public:
 			T acc;
 			inner_acc(T&& acc) : acc(std::forward<T>(acc)) {}
 			bool can_accept(const base_acc_type::head_t &head) override { return acc.can_accept(head); }
+			std::optional<acceptor_key> selection_key() const override { return acc.selection_key(); }
 			void on_head(const base_acc_type::head_t &head) override { acc.on_head(head); }
+			void on_selected_head(const base_acc_type::head_t &head) override { acc.on_selected_head(head); }
 			void on_message(const base_acc_type::head_t &head, const base_acc_type::data_view &body, std::size_t tail) override
 			{ return acc.on_message(head, body, tail); }
 			void on_error(const base_acc_type::head_t &head, const base_acc_type::data_view &body) override
 			{ return acc.on_error(head, body); }
+			std::size_t on_upgraded(const base_acc_type::head_t &head, const base_acc_type::data_view &data) override
+			{ return acc.on_upgraded(head, data); }
 		} ;
 		queue.emplace_back(std::make_shared<inner_acc>(std::forward<T>(acc)));
+		index(*queue.back());
 	}
 
 	std::size_t chain_size() const
@@ -75,29 +241,121 @@ public:
 	}
 
 	decltype(queue)::value_type search(const head_t& head) const {
-		for(auto& a:queue) if(a->can_accept(head)) return a;
-		return nullptr;
+		auto ind = select(head);
+		return ind == none ? nullptr : queue[ind];
 	}
 
 	bool can_accept(const head_t& head) override
 	{
-		return search(head) != nullptr;
+		return find_acceptor(head) != nullptr;
 	}
 
 	void on_head(const head_t& head) override
 	{
-		auto a = search(head);
-		if(a) a->on_head(head);
+		auto a = bind(head);
+		if(a) a->on_selected_head(head);
 	}
 
 	void on_message(const head_t& head, const data_view& body, std::size_t tail) override {
-		auto a = search(head);
+		auto a = bound(head);
 		if(a) a->on_message(head, body, tail);
 	}
 	void on_error(const head_t& head, const data_view& body) override {
-		auto a = search(head);
+		auto a = bound(head);
 		if(a) a->on_error(head, body);
 	}
+	std::size_t on_upgraded(const head_t& head, const data_view& data) override {
+		auto a = bound(head);
+		return a ? a->on_upgraded(head, data) : 0;
+	}
+};
+
+// the same as http1_parser_chain_acceptor but the acceptors are known at
+// compile time: they are stored in place and called directly, the first
+// one whose can_accept returns true (or without can_accept) is selected.
+// the acceptors don't need to derive from chainable_acceptor.
+// it is not thread safe for the same reason as http1_parser_chain_acceptor.
+template<typename Head, typename DataContainer, typename... Acceptors>
+struct static_chain_acceptor final : public chainable_acceptor<Head, DataContainer> {
+	using base_acc_type = chainable_acceptor<Head, DataContainer>;
+	using head_t = base_acc_type::head_t;
+	using data_view = base_acc_type::data_view;
+	constexpr static std::size_t npos = sizeof...(Acceptors);
+private:
+	std::tuple<Acceptors...> accs;
+	chain_acceptor_details::binding_table<head_t, std::size_t> bindings;
+
+	template<typename A>
+	static bool accepts(A& acc, const head_t& head)
+	{
+		if constexpr (requires{ acc.can_accept(head); }) return acc.can_accept(head);
+		else return true;
+	}
+
+	template<typename Functor>
+	void visit(std::size_t ind, Functor&& fnc)
+	{
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			(void)((I == ind ? (fnc(std::get<I>(accs)), true) : false) || ...);
+		}(std::index_sequence_for<Acceptors...>{});
+	}
+
+	std::size_t bind(const head_t& head)
+	{
+		return bindings.bind(head, [this](const head_t& h){ return select(h); });
+	}
+
+	std::size_t bound(const head_t& head)
+	{
+		return bindings.bound(head, [this](const head_t& h){ return select(h); });
+	}
+public:
+	template<typename... Args>
+	static_chain_acceptor(Args&&... args) : accs(std::forward<Args>(args)...) {}
+
+	template<std::size_t I> auto& get() { return std::get<I>(accs); }
+	template<std::size_t I> const auto& get() const { return std::get<I>(accs); }
+
+	constexpr static std::size_t chain_size() { return sizeof...(Acceptors); }
+
+	std::size_t select(const head_t& head)
+	{
+		std::size_t ret = npos;
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			(void)((accepts(std::get<I>(accs), head) ? (ret = I, true) : false) || ...);
+		}(std::index_sequence_for<Acceptors...>{});
+		return ret;
+	}
+
+	bool can_accept(const head_t& head) override
+	{
+		return select(head) != npos;
+	}
+
+	void on_head(const head_t& head) override
+	{
+		visit(bind(head), [&head](auto& a){
+			if constexpr (requires{ a.on_selected_head(head); }) a.on_selected_head(head);
+			else a.on_head(head);
+		});
+	}
+	void on_message(const head_t& head, const data_view& body, std::size_t tail) override
+	{
+		visit(bound(head), [&](auto& a){ a.on_message(head, body, tail); });
+	}
+	void on_error(const head_t& head, const data_view& body) override
+	{
+		visit(bound(head), [&](auto& a){ a.on_error(head, body); });
+	}
+	std::size_t on_upgraded(const head_t& head, const data_view& data) override
+	{
+		std::size_t ret = 0;
+		visit(bound(head), [&](auto& a){
+			if constexpr (requires{ a.on_upgraded(head, data); }) ret = a.on_upgraded(head, data);
+			else a.on_message(head, data, 0);
+		});
+		return ret;
+	}
 };
 
 
@@ -160,6 +418,8 @@ public:
 
 	using acceptor_type = acceptor_template<http1_parser_acceptor>;
 	using chain_acceptor_type =  acceptor_template<http1_parser_chain_acceptor>;
+	template<typename... Acceptors>
+	using static_chain_acceptor_type = static_chain_acceptor<message_t, data_container_t, Acceptors...>;
 	using data_view_t = basic_position_string_view<data_container_t>;
 private:
 
@@ -208,17 +468,18 @@ private:
 		else if(result_msg.headers().is_chunked())
 			parse_chunked_body();
 		else if(auto uph = result_msg.headers().upgrade_header();uph) {
-			acceptor->on_message(result_msg, body_view, 0);
-			clean_body(parser_hdrs.finish_position());
+			const std::size_t used = acceptor->on_upgraded(result_msg, body_view);
+			assert( used <= body_view.size() );
+			clean_body(parser_hdrs.finish_position() + used);
 		}
 	}
 
 	void clean_body(std::size_t actual_pos)
 	{
 		assert( actual_pos <= data.size() );
-		if(data.size() - 1 <= actual_pos)
+		if(data.size() <= actual_pos)
 			data.resize(parser_hdrs.finish_position());
-		else {
+		else if(parser_hdrs.finish_position() < actual_pos) {
 			auto body = df();
 			for(std::size_t i=actual_pos;i<data.size();++i)
 				body.push_back(data[i]);
@@ -0,0 +1,56 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <span>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::size_t base64_size(std::size_t src_size) { return (src_size + 2) / 3 * 4; }
+
+// encodes src into out (base64_size(src.size()) bytes), with padding
+constexpr std::size_t base64_encode(std::span<const std::uint8_t> src, char* out)
+{
+	constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::size_t pos = 0, i = 0;
+	for(;i + 3 <= src.size();i += 3) {
+		const std::uint32_t v = (std::uint32_t(src[i]) << 16) | (std::uint32_t(src[i+1]) << 8) | src[i+2];
+		out[pos++] = alphabet[(v >> 18) & 0x3F];
+		out[pos++] = alphabet[(v >> 12) & 0x3F];
+		out[pos++] = alphabet[(v >> 6) & 0x3F];
+		out[pos++] = alphabet[v & 0x3F];
+	}
+	if(i < src.size()) {
+		const bool two = i + 1 < src.size();
+		const std::uint32_t v = (std::uint32_t(src[i]) << 16) | (two ? std::uint32_t(src[i+1]) << 8 : 0);
+		out[pos++] = alphabet[(v >> 18) & 0x3F];
+		out[pos++] = alphabet[(v >> 12) & 0x3F];
+		out[pos++] = two ? alphabet[(v >> 6) & 0x3F] : '=';
+		out[pos++] = '=';
+	}
+	return pos;
+}
+
+// size of decoded data or npos if src is not a valid padded base64
+constexpr std::size_t base64_decoded_size(std::string_view src)
+{
+	constexpr std::size_t npos = static_cast<std::size_t>(-1);
+	if(src.size() % 4 != 0) return npos;
+	std::size_t pad = 0;
+	for(std::size_t i=0;i<src.size();++i) {
+		const char c = src[i];
+		const bool alpha = ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || ('0' <= c && c <= '9') || c == '+' || c == '/';
+		if(c == '=' && src.size() - 2 <= i && (pad != 0 || i + 1 == src.size() || src[i+1] == '=')) ++pad;
+		else if(!alpha || pad != 0) return npos;
+	}
+	return src.size() / 4 * 3 - pad;
+}
+
+} // namespace http_parser
@@ -0,0 +1,88 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <chrono>
+#include <limits>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::size_t imf_fixdate_size = 29;
+using imf_fixdate = std::array<char, imf_fixdate_size>;
+
+// formats "Sun, 06 Nov 1994 08:49:37 GMT" (RFC 9110 5.6.7)
+// seconds are counted from unix epoch
+constexpr imf_fixdate format_imf_fixdate(std::int64_t seconds)
+{
+	constexpr std::string_view days_names = "SunMonTueWedThuFriSat";
+	constexpr std::string_view month_names = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	std::int64_t days = seconds / 86400;
+	std::int64_t rem = seconds % 86400;
+	if(rem < 0) rem += 86400, --days;
+	const std::int64_t wday = ((days % 7) + 11) % 7; // 1970-01-01 is thursday
+
+	// civil_from_days by Howard Hinnant
+	const std::int64_t z = days + 719468;
+	const std::int64_t era = (0 <= z ? z : z - 146096) / 146097;
+	const std::int64_t doe = z - era * 146097;
+	const std::int64_t yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+	const std::int64_t doy = doe - (365*yoe + yoe/4 - yoe/100);
+	const std::int64_t mp = (5*doy + 2)/153;
+	const std::int64_t day = doy - (153*mp+2)/5 + 1;
+	const std::int64_t month = mp < 10 ? mp+3 : mp-9;
+	const std::int64_t year = yoe + era * 400 + (month <= 2);
+
+	imf_fixdate ret{};
+	std::size_t pos = 0;
+	auto put = [&ret,&pos](char c){ ret[pos++] = c; };
+	auto put2 = [&put](std::int64_t v){ put('0' + v / 10); put('0' + v % 10); };
+	for(std::size_t i=0;i<3;++i) put(days_names[wday*3 + i]);
+	put(',');
+	put(' ');
+	put2(day);
+	put(' ');
+	for(std::size_t i=0;i<3;++i) put(month_names[(month-1)*3 + i]);
+	put(' ');
+	put2(year / 100 % 100);
+	put2(year % 100);
+	put(' ');
+	put2(rem / 3600);
+	put(':');
+	put2(rem / 60 % 60);
+	put(':');
+	put2(rem % 60);
+	put(' ');
+	put('G');
+	put('M');
+	put('T');
+	return ret;
+}
+
+// Date header value cached per thread: it is formatted again only
+// when the second is changed.
+template<typename Clock = std::chrono::system_clock>
+struct cached_date {
+	static std::string_view now()
+	{
+		using namespace std::chrono;
+		thread_local std::int64_t cached_sec = std::numeric_limits<std::int64_t>::min();
+		thread_local imf_fixdate value{};
+		const std::int64_t sec = duration_cast<seconds>(Clock::now().time_since_epoch()).count();
+		if(sec != cached_sec) {
+			value = format_imf_fixdate(sec);
+			cached_sec = sec;
+		}
+		return std::string_view(value.data(), value.size());
+	}
+};
+
+} // namespace http_parser
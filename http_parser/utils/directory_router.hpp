@@ -7,40 +7,80 @@
  * See accompanying file LICENSE (at the root of this repository)
  *************************************************************************/
 
+#include <stdexcept>
 #include <memory_resource>
 #include "factories.hpp"
+#include "radix_tree.hpp"
+#include "methods.hpp"
 
 namespace http_parser {
 
+enum class route_status { found, not_found, method_not_allowed };
+
 namespace directory_router_details {
 
-template<typename StringView>
-struct caller {
-	virtual ~caller(){}
-	virtual void call(StringView sv) const =0 ;
-	virtual bool match(StringView sv) const =0 ;
-};
+constexpr std::size_t max_captures = 8;
 
-template<typename R, typename S>
-struct caller_deleter {
-	R* mem;
-	std::size_t sz;
-	caller_deleter(R* mem, std::size_t sz) : mem(mem), sz(sz) {}
-	void operator()(caller<S>* o) const
+// routes registered for the same pattern: index + 1 of the route
+// for each method, the last one is for routes without method
+struct route_slot {
+	std::array<std::uint32_t, methods_count + 1> routes{};
+	std::uint32_t& any() { return routes.back(); }
+	std::uint32_t find(methods m) const
 	{
-		o->~caller();
-		mem->deallocate(o, sz);
+		std::uint32_t ret = m == methods::unknown ? 0 : routes[static_cast<std::size_t>(m)];
+		return ret == 0 ? routes.back() : ret;
 	}
 };
 
-template<typename S>
-bool match_substr(S pattern, S str)
+template<typename StringView>
+using captures = route_captures<StringView, max_captures>;
+
+template<typename Functor, typename StringView>
+void invoke(const Functor& fnc, StringView sv, const captures<StringView>& caps)
 {
-	return pattern.size() <= str.size() && str.substr(0, pattern.size()) == pattern;
+	if constexpr (requires{ fnc(sv, caps); }) fnc(sv, caps);
+	else if constexpr (requires{ fnc(caps); }) fnc(caps);
+	else if constexpr (requires{ fnc(sv); }) fnc(sv);
+	else fnc();
 }
 
-template<typename R, typename S>
-using caller_ptr = std::unique_ptr<caller<S>, caller_deleter<R, S>>;
+// type erased functor: small trivial functors (lambdas with few
+// references) are stored inside, others are allocated from router's
+// memory resource. it's plain data, so handlers are kept in one array.
+template<typename StringView, typename MR>
+struct handler {
+	constexpr static std::size_t local_size = 2 * sizeof(void*);
+
+	void (*call)(const void* obj, StringView sv, const captures<StringView>& caps) = nullptr;
+	void (*destroy)(void* obj, MR* mem) = nullptr;
+	void* heap = nullptr;
+	bool prefix = false;
+	alignas(void*) std::array<std::byte, local_size> local;
+
+	const void* object() const { return heap ? heap : local.data(); }
+
+	template<typename Functor>
+	constexpr static bool is_local =
+	        sizeof(Functor) <= local_size
+	     && alignof(Functor) <= alignof(void*)
+	     && std::is_trivially_copyable_v<Functor>
+	     && std::is_trivially_destructible_v<Functor>
+	     ;
+};
+
+template<typename Functor, typename StringView>
+void call_functor(const void* obj, StringView sv, const captures<StringView>& caps)
+{
+	invoke(*static_cast<const Functor*>(obj), sv, caps);
+}
+
+template<typename Functor, typename MR>
+void destroy_functor(void* obj, MR* mem)
+{
+	static_cast<Functor*>(obj)->~Functor();
+	mem->deallocate(obj, sizeof(Functor), alignof(Functor));
+}
 
 } // namespace directory_router_details
 
@@ -48,18 +88,27 @@ template<
 	  typename ContainerFactory = pmr_vector_factory
 	, typename MR = std::pmr::memory_resource
 	, typename StringView = std::string_view
-	, typename Container = decltype(std::declval<ContainerFactory>().template operator()<directory_router_details::caller_ptr<MR, StringView>>())
+	, typename Container = decltype(std::declval<ContainerFactory>().template operator()<directory_router_details::handler<StringView, MR>>())
 	>
 struct directory_router final {
 
-	using caller_ptr = directory_router_details::caller_ptr<MR, StringView>;
+	using tree_t = radix_tree<StringView, ContainerFactory, directory_router_details::max_captures>;
+	using captures_t = typename tree_t::captures_t;
+	using handler_t = directory_router_details::handler<StringView, MR>;
+	using route_slot = directory_router_details::route_slot;
+
+	directory_router(const directory_router&) =delete ;
+	directory_router& operator = (const directory_router&) =delete ;
 
 	directory_router(directory_router&& other)
 	    : mem(other.mem)
 	    , factory(std::move(other.factory))
-	    , routes(factory.template operator()<caller_ptr>())
+	    , handlers(factory.template operator()<handler_t>())
+	    , tree(std::move(other.tree))
+	    , slots(std::move(other.slots))
 	{
-		routes = std::move(other.routes);
+		handlers = std::move(other.handlers);
+		other.handlers.clear();
 	}
 
 	explicit directory_router(MR* mr = std::pmr::get_default_resource())
@@ -70,83 +119,101 @@ struct directory_router final {
 	directory_router(MR* mr, ContainerFactory cf)
 	    : mem(mr)
 	    , factory(std::move(cf))
-	    , routes(factory.template operator()<caller_ptr>())
+	    , handlers(factory.template operator()<handler_t>())
+	    , tree(factory)
+	    , slots(factory.template operator()<route_slot>())
 	{
 	}
 
+	~directory_router()
+	{
+		for(auto& h:handlers) if(h.heap) h.destroy(h.heap, mem);
+	}
+
 	template<typename Functor>
 	auto& add(StringView route, Functor&& fnc)
 	{
-		if(route.back() == '/') add_substr(route, std::forward<Functor>(fnc));
-		else add_exactly(route, std::forward<Functor>(fnc));
+		return add(methods::unknown, route, std::forward<Functor>(fnc));
+	}
+
+	// the route serves only the method m, methods::unknown means any method
+	template<typename Functor>
+	auto& add(methods m, StringView route, Functor&& fnc)
+	{
+		using functor_t = std::decay_t<Functor>;
+		handler_t h;
+		h.call = &directory_router_details::call_functor<functor_t, StringView>;
+		h.prefix = route.back() == '/';
+		if constexpr (handler_t::template is_local<functor_t>) {
+			new (h.local.data()) functor_t(std::forward<Functor>(fnc));
+		} else {
+			void* allocated = mem->allocate(sizeof(functor_t), alignof(functor_t));
+			try { new (allocated) functor_t(std::forward<Functor>(fnc)); }
+			catch(...) { mem->deallocate(allocated, sizeof(functor_t), alignof(functor_t)); throw; }
+			h.heap = allocated;
+			h.destroy = &directory_router_details::destroy_functor<functor_t, MR>;
+		}
+
+		try {
+			auto& target = route_target(m, route, h.prefix);
+			if(target != 0) throw std::runtime_error("route is already added");
+			handlers.emplace_back(h);
+			target = static_cast<std::uint32_t>(handlers.size());
+		}
+		catch(...) { if(h.heap) h.destroy(h.heap, mem); throw; }
 		return *this;
 	}
 
+	// routes ended with '/' match by prefix, the longest prefix wins;
+	// other routes match exactly and preferred to prefix ones.
+	// a segment {name} matches any segment, the functor can receive the
+	// values as captures_t (and the path or tail as first argument)
 	bool operator()(StringView route) const
 	{
-		for(auto& r:routes) {
-			if(r->match(route))
-				return r->call(route), true;
-		}
-		return false;
+		return (*this)(methods::unknown, route) == route_status::found;
 	}
 
-	auto size() { return routes.size(); }
-private:
-	template<typename Functor>
-	void add_substr(StringView route, Functor&& fnc)
+	// the path is matched first and then the method for it, so
+	// method_not_allowed is returned if the path is known but
+	// there is no route for the method (the 405 case)
+	route_status operator()(methods m, StringView route) const
 	{
-		struct helper_substr : directory_router_details::caller<StringView> {
-			Functor fnc;
-			StringView pattern;
-			helper_substr(Functor&& fnc, StringView p) : fnc(std::forward<Functor>(fnc)), pattern(p) {}
-			bool match(StringView sv) const override {
-				return directory_router_details::match_substr(pattern, sv);
-			}
-			void call(StringView sv) const override {
-				if constexpr (requires(StringView s){fnc(s);}) fnc(sv.substr(pattern.size()));
-				else fnc();
-			}
-		};
-
-		add<helper_substr>(route, std::forward<Functor>(fnc));
+		captures_t caps;
+		auto found = tree.find(route, caps);
+		if(!found) return route_status::not_found;
+		std::uint32_t ind = slots[found.value].find(m);
+		if(ind == 0) return route_status::method_not_allowed;
+		const handler_t& h = handlers[ind - 1];
+		h.call(h.object(), h.prefix ? route.substr(found.matched) : route, caps);
+		return route_status::found;
 	}
 
-	template<typename Functor>
-	void add_exactly(StringView route, Functor&& fnc)
+	template<typename Head>
+	requires requires(const Head& h){ h.method_code(); h.url().path(); }
+	route_status operator()(const Head& head) const
 	{
-		struct helper_exactly : directory_router_details::caller<StringView> {
-			Functor fnc;
-			StringView pattern;
-			helper_exactly(Functor&& fnc, StringView p) : fnc(std::forward<Functor>(fnc)), pattern(p) {}
-			bool match(StringView sv) const override {
-				return pattern == sv;
-			}
-			void call(StringView sv) const override {
-				if constexpr (requires(StringView s){fnc(s);}) fnc(sv);
-				else fnc();
-			}
-		};
-
-		add<helper_exactly>(route, std::forward<Functor>(fnc));
+		return (*this)(head.method_code(), StringView(head.url().path()));
 	}
 
-	template<typename T, typename Functor>
-	inline void add(StringView route, Functor&& fnc)
+	auto size() { return handlers.size(); }
+private:
+	// slot of the handler index (1 based, 0 is no handler) for the route
+	std::uint32_t& route_target(methods m, StringView route, bool prefix)
 	{
-		constexpr std::size_t size = sizeof(T);
-		auto allocated = mem->allocate(size);
-		directory_router_details::caller_deleter<MR, StringView> deleter(mem, size);
-		directory_router_details::caller_ptr ptr(
-		    new (allocated) T(std::forward<Functor>(fnc), route),
-		    std::move(deleter)
-		    );
-		routes.emplace_back(std::move(ptr));
+		auto& slot_ind = tree.value(route, prefix);
+		if(slot_ind == tree_t::npos) {
+			slots.emplace_back();
+			slot_ind = static_cast<typename tree_t::index_t>(slots.size() - 1);
+		}
+		auto& slot = slots[slot_ind];
+		return m == methods::unknown ? slot.any() : slot.routes[static_cast<std::size_t>(m)];
 	}
 
 	MR* mem;
 	ContainerFactory factory;
-	Container routes;
+	Container handlers;
+	tree_t tree;
+	decltype(std::declval<ContainerFactory>().template operator()<route_slot>()) slots;
 };
 
 } // namespace http_parser
@@ -0,0 +1,29 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <cstddef>
+#include <string_view>
+
+namespace http_parser {
+
+// string literal which can be used as template parameter
+template<std::size_t N>
+struct fixed_string {
+	char value[N]{};
+
+	constexpr fixed_string(const char (&str)[N])
+	{
+		for(std::size_t i=0;i<N;++i) value[i] = str[i];
+	}
+
+	constexpr std::size_t size() const { return N - 1; }
+	constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+};
+
+} // namespace http_parser
@@ -0,0 +1,234 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <utility>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include "factories.hpp"
+
+namespace http_parser {
+
+namespace host_router_details {
+
+constexpr char lower(char c)
+{
+	return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr std::uint32_t hash(std::string_view host)
+{
+	std::uint32_t h = 2166136261u;
+	for(char c:host) {
+		h ^= (unsigned char)lower(c);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// removes port and the trailing dot: "Example.com.:8080" -> "Example.com"
+constexpr std::string_view normalize(std::string_view host)
+{
+	if(!host.empty() && host.front() == '[') {
+		auto end = host.find(']');
+		return end == std::string_view::npos ? host : host.substr(0, end + 1);
+	}
+	if(auto port = host.rfind(':'); port != std::string_view::npos) host = host.substr(0, port);
+	if(!host.empty() && host.back() == '.') host.remove_suffix(1);
+	return host;
+}
+
+} // namespace host_router_details
+
+// selects a router by the Host header. exact host names are looked up
+// in a hash table, wildcards ("*.example.com") in a trie of reversed
+// host names, so the lookup is O(host size) for any number of hosts.
+// the exact name is preferred, then the longest wildcard suffix.
+// names are case insensitive, the port is ignored.
+template<typename Router, typename ContainerFactory = pmr_vector_factory>
+class host_router final {
+	using index_t = std::uint32_t;
+	constexpr static index_t npos = static_cast<index_t>(-1);
+
+	struct exact_host {
+		std::size_t offset;
+		std::size_t size;
+		index_t router;
+	};
+
+	struct slot {
+		std::uint32_t hash = 0;
+		index_t host = npos;
+	};
+
+	struct trie_node {
+		char symbol = 0;
+		index_t first_child = npos;
+		index_t next_sibling = npos;
+		index_t router = npos;
+	};
+
+	using routers_t = decltype(std::declval<ContainerFactory>().template operator()<Router>());
+	using names_t = decltype(std::declval<ContainerFactory>().template operator()<char>());
+	using hosts_t = decltype(std::declval<ContainerFactory>().template operator()<exact_host>());
+	using slots_t = decltype(std::declval<ContainerFactory>().template operator()<slot>());
+	using trie_t = decltype(std::declval<ContainerFactory>().template operator()<trie_node>());
+
+	ContainerFactory factory;
+	routers_t routers;
+	names_t names;
+	hosts_t hosts;
+	slots_t slots;
+	trie_t trie;
+
+	std::string_view name(const exact_host& h) const
+	{
+		return std::string_view(names.data() + h.offset, h.size);
+	}
+
+	static bool same(std::string_view stored, std::string_view host)
+	{
+		if(stored.size() != host.size()) return false;
+		for(std::size_t i=0;i<host.size();++i)
+			if(stored[i] != host_router_details::lower(host[i])) return false;
+		return true;
+	}
+
+	index_t find_exact(std::string_view host) const
+	{
+		if(slots.empty()) return npos;
+		const std::uint32_t h = host_router_details::hash(host);
+		const std::size_t mask = slots.size() - 1;
+		for(std::size_t i=h&mask;slots[i].host!=npos;i=(i+1)&mask) {
+			auto& s = slots[i];
+			if(s.hash == h && same(name(hosts[s.host]), host)) return hosts[s.host].router;
+		}
+		return npos;
+	}
+
+	void insert_slot(std::uint32_t h, index_t host)
+	{
+		const std::size_t mask = slots.size() - 1;
+		std::size_t i = h & mask;
+		while(slots[i].host != npos) i = (i+1) & mask;
+		slots[i].hash = h;
+		slots[i].host = host;
+	}
+
+	void rehash(std::size_t size)
+	{
+		slots.clear();
+		slots.resize(size);
+		for(std::size_t i=0;i<hosts.size();++i)
+			insert_slot(host_router_details::hash(name(hosts[i])), static_cast<index_t>(i));
+	}
+
+	void add_exact(std::string_view host, index_t router)
+	{
+		if(find_exact(host) != npos)
+			throw std::runtime_error("host is already added");
+		exact_host eh{ names.size(), host.size(), router };
+		for(char c:host) names.push_back(host_router_details::lower(c));
+		hosts.push_back(eh);
+		if(slots.size() < hosts.size() * 2) rehash(slots.empty() ? 16 : slots.size() * 2);
+		else insert_slot(host_router_details::hash(host), static_cast<index_t>(hosts.size()-1));
+	}
+
+	index_t child(index_t node, char c) const
+	{
+		for(index_t cur=trie[node].first_child;cur!=npos;cur=trie[cur].next_sibling)
+			if(trie[cur].symbol == c) return cur;
+		return npos;
+	}
+
+	// suffix includes the leading dot: ".example.com"
+	void add_wildcard(std::string_view suffix, index_t router)
+	{
+		if(trie.empty()) trie.emplace_back();
+		index_t node = 0;
+		for(auto pos=suffix.rbegin();pos!=suffix.rend();++pos) {
+			const char c = host_router_details::lower(*pos);
+			index_t next = child(node, c);
+			if(next == npos) {
+				next = static_cast<index_t>(trie.size());
+				trie.emplace_back();
+				trie.back().symbol = c;
+				trie.back().next_sibling = trie[node].first_child;
+				trie[node].first_child = next;
+			}
+			node = next;
+		}
+		if(trie[node].router != npos)
+			throw std::runtime_error("host is already added");
+		trie[node].router = router;
+	}
+
+	index_t find_wildcard(std::string_view host) const
+	{
+		if(trie.empty()) return npos;
+		index_t node = 0, found = npos;
+		for(auto pos=host.rbegin();pos!=host.rend();++pos) {
+			node = child(node, host_router_details::lower(*pos));
+			if(node == npos) break;
+			// the wildcard should match at least one symbol
+			if(trie[node].router != npos && std::next(pos) != host.rend()) found = trie[node].router;
+		}
+		return found;
+	}
+public:
+	explicit host_router(ContainerFactory cf = ContainerFactory{})
+	    : factory(std::move(cf))
+	    , routers(factory.template operator()<Router>())
+	    , names(factory.template operator()<char>())
+	    , hosts(factory.template operator()<exact_host>())
+	    , slots(factory.template operator()<slot>())
+	    , trie(factory.template operator()<trie_node>())
+	{
+	}
+
+	// host is an exact name or "*.suffix" wildcard.
+	// the returned reference is valid until next add.
+	Router& add(std::string_view host, Router r)
+	{
+		host = host_router_details::normalize(host);
+		if(host.empty() || host == std::string_view("*")) throw std::runtime_error("wrong host");
+		const index_t ind = static_cast<index_t>(routers.size());
+		if(host.starts_with("*.")) add_wildcard(host.substr(1), ind);
+		else add_exact(host, ind);
+		routers.emplace_back(std::move(r));
+		return routers.back();
+	}
+
+	const Router* find(std::string_view host) const
+	{
+		host = host_router_details::normalize(host);
+		index_t ind = find_exact(host);
+		if(ind == npos) ind = find_wildcard(host);
+		return ind == npos ? nullptr : &routers[ind];
+	}
+
+	Router* find(std::string_view host)
+	{
+		return const_cast<Router*>(std::as_const(*this).find(host));
+	}
+
+	// finds by the Host header of a parsed message
+	template<typename Headers>
+	requires requires(const Headers& h){ h.find_header("Host"); }
+	const Router* find(const Headers& msg) const
+	{
+		auto host = msg.find_header("Host");
+		return host ? find(std::string_view(*host)) : nullptr;
+	}
+
+	std::size_t size() const { return routers.size(); }
+};
+
+} // namespace http_parser
@@ -40,6 +40,7 @@ public:
 	}
 
 	bool empty() const { return cur_size == 0; }
+	void clear() { cur_size = 0; }
 	T& back() { return con[cur_size-1]; }
 	const T& back() const { return con[cur_size-1]; }
 
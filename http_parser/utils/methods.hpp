@@ -0,0 +1,69 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+enum class methods { get, head, post, put, delete_method, connect, trace, patch, options, unknown };
+constexpr std::size_t methods_count = static_cast<std::size_t>(methods::unknown);
+
+inline std::string_view to_string_view(methods m)
+{
+	using namespace std::literals;
+	if(m == methods::get) return "GET"sv;
+	if(m == methods::head) return "HEAD"sv;
+	if(m == methods::post) return "POST"sv;
+	if(m == methods::put) return "PUT"sv;
+	if(m == methods::delete_method) return "DELETE"sv;
+	if(m == methods::connect) return "CONNECT"sv;
+	if(m == methods::trace) return "TRACE"sv;
+	if(m == methods::patch) return "PATCH"sv;
+	if(m == methods::options) return "OPTIONS"sv;
+	assert(false);
+	return ""sv;
+}
+
+namespace details {
+
+constexpr std::uint64_t pack_method(std::string_view name)
+{
+	std::uint64_t ret = 0;
+	for(std::size_t i=0;i<name.size();++i) ret |= std::uint64_t((unsigned char)name[i]) << (8*i);
+	return ret;
+}
+
+} // namespace details
+
+// the method name is packed to single word and compared with
+// precomputed values, so it's one switch instead of string compares
+template<typename View>
+methods classify_method(const View& name)
+{
+	using details::pack_method;
+	if(name.size() < 3 || 7 < name.size()) return methods::unknown;
+	std::uint64_t word = 0;
+	for(std::size_t i=0;i<name.size();++i) word |= std::uint64_t((unsigned char)name[i]) << (8*i);
+	switch(word) {
+	case pack_method("GET"): return methods::get;
+	case pack_method("HEAD"): return methods::head;
+	case pack_method("POST"): return methods::post;
+	case pack_method("PUT"): return methods::put;
+	case pack_method("DELETE"): return methods::delete_method;
+	case pack_method("CONNECT"): return methods::connect;
+	case pack_method("TRACE"): return methods::trace;
+	case pack_method("PATCH"): return methods::patch;
+	case pack_method("OPTIONS"): return methods::options;
+	}
+	return methods::unknown;
+}
+
+} // namespace http_parser
@@ -0,0 +1,239 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include "factories.hpp"
+
+namespace http_parser {
+
+// values of {name} segments, in the pattern order
+template<typename StringView, std::size_t N>
+struct route_captures {
+	std::array<StringView, N> values{};
+	std::size_t count = 0;
+
+	std::size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	void assign(const route_captures& other)
+	{
+		for(std::size_t i=0;i<other.count;++i) values[i] = other.values[i];
+		count = other.count;
+	}
+	const StringView& operator[](std::size_t ind) const { return values[ind]; }
+	auto begin() const { return values.begin(); }
+	auto end() const { return values.begin() + count; }
+};
+
+// compressed prefix tree: maps keys to values (indexes in some external
+// storage). each key is exact or prefix one, lookup returns the exact
+// match or the longest prefix. a key segment in form {name} matches any
+// non empty segment and the matched value is captured.
+// the tree doesn't own the keys: they must outlive it.
+template<
+	  typename StringView = std::string_view
+	, typename ContainerFactory = pmr_vector_factory
+	, std::size_t MaxCaptures = 8
+	>
+class radix_tree final {
+public:
+	using captures_t = route_captures<StringView, MaxCaptures>;
+	using index_t = std::uint32_t;
+	constexpr static index_t npos = static_cast<index_t>(-1);
+
+	struct result {
+		index_t value = npos;
+		std::size_t matched = 0;
+		bool exact = false;
+		explicit operator bool() const { return value != npos; }
+	};
+private:
+	struct node {
+		StringView label;
+		index_t first_child = npos;
+		index_t next_sibling = npos;
+		index_t param_child = npos;
+		index_t exact = npos;
+		index_t prefix = npos;
+	};
+
+	using char_t = typename StringView::value_type;
+
+	using container_t = decltype(std::declval<ContainerFactory>().template operator()<node>());
+	container_t nodes;
+
+	static std::size_t common_size(StringView l, StringView r)
+	{
+		std::size_t ret = 0, end = std::min(l.size(), r.size());
+		while(ret < end && l[ret] == r[ret]) ++ret;
+		return ret;
+	}
+
+	index_t find_child(index_t parent, typename StringView::value_type c) const
+	{
+		for(index_t i=nodes[parent].first_child;i!=npos;i=nodes[i].next_sibling) {
+			auto first = nodes[i].label[0];
+			if(first == c) return i;
+			if(c < first) break;
+		}
+		return npos;
+	}
+
+	index_t create(StringView label)
+	{
+		nodes.emplace_back(node{ label });
+		return static_cast<index_t>(nodes.size() - 1);
+	}
+
+	void link_child(index_t parent, index_t child)
+	{
+		auto first = nodes[child].label[0];
+		index_t* place = &nodes[parent].first_child;
+		while(*place != npos && nodes[*place].label[0] < first)
+			place = &nodes[*place].next_sibling;
+		nodes[child].next_sibling = *place;
+		*place = child;
+	}
+
+	void replace_child(index_t parent, index_t old_child, index_t new_child)
+	{
+		index_t* place = &nodes[parent].first_child;
+		while(*place != old_child) place = &nodes[*place].next_sibling;
+		nodes[new_child].next_sibling = nodes[old_child].next_sibling;
+		nodes[old_child].next_sibling = npos;
+		*place = new_child;
+	}
+
+	index_t find_or_create(index_t cur, StringView key)
+	{
+		while(!key.empty()) {
+			index_t child = find_child(cur, key[0]);
+			if(child == npos) {
+				child = create(key);
+				link_child(cur, child);
+				return child;
+			}
+			StringView label = nodes[child].label;
+			std::size_t common = common_size(label, key);
+			if(common < label.size()) {
+				index_t mid = create(label.substr(0, common));
+				replace_child(cur, child, mid);
+				nodes[child].label = label.substr(common);
+				nodes[mid].first_child = child;
+				child = mid;
+			}
+			cur = child;
+			key = key.substr(common);
+		}
+		return cur;
+	}
+
+	index_t find_or_create(StringView key)
+	{
+		index_t cur = 0;
+		std::size_t params = 0;
+		for(std::size_t open=key.find((char_t)'{');open!=StringView::npos;open=key.find((char_t)'{')) {
+			std::size_t close = key.find((char_t)'}', open);
+			const bool whole_segment =
+			        close != StringView::npos
+			     && (open == 0 || key[open-1] == (char_t)'/')
+			     && (close + 1 == key.size() || key[close+1] == (char_t)'/');
+			if(!whole_segment)
+				throw std::runtime_error("route parameter should be a whole path segment");
+			if(MaxCaptures <= params++)
+				throw std::runtime_error("too many parameters in route");
+			cur = find_or_create(cur, key.substr(0, open));
+			if(nodes[cur].param_child == npos) {
+				index_t param = create(StringView{});
+				nodes[cur].param_child = param;
+			}
+			cur = nodes[cur].param_child;
+			key = key.substr(close + 1);
+		}
+		return find_or_create(cur, key);
+	}
+
+	bool walk(index_t cur, StringView path, std::size_t pos, captures_t& caps, result& best, captures_t& best_caps) const
+	{
+		const node& n = nodes[cur];
+		if(n.prefix != npos && (best.value == npos || best.matched < pos)) {
+			best = result{ n.prefix, pos, false };
+			best_caps.assign(caps);
+		}
+		if(pos == path.size()) {
+			if(n.exact == npos) return false;
+			best = result{ n.exact, pos, true };
+			best_caps.assign(caps);
+			return true;
+		}
+		if(index_t child = find_child(cur, path[pos]); child != npos) {
+			StringView label = nodes[child].label;
+			const bool match = label.size() <= path.size() - pos && path.substr(pos, label.size()) == label;
+			if(match && walk(child, path, pos + label.size(), caps, best, best_caps)) return true;
+		}
+		if(n.param_child != npos) {
+			std::size_t end = path.find((char_t)'/', pos);
+			if(end == StringView::npos) end = path.size();
+			if(end != pos) {
+				caps.values[caps.count++] = path.substr(pos, end - pos);
+				if(walk(n.param_child, path, end, caps, best, best_caps)) return true;
+				--caps.count;
+			}
+		}
+		return false;
+	}
+public:
+	radix_tree() requires std::is_default_constructible_v<ContainerFactory>
+	    : radix_tree(ContainerFactory{})
+	{}
+
+	explicit radix_tree(const ContainerFactory& cf)
+	    : nodes(cf.template operator()<node>())
+	{
+		create(StringView{});
+	}
+
+	// the value for the key, it's npos if the key is new
+	index_t& value(StringView key, bool prefix)
+	{
+		index_t n = find_or_create(key);
+		return prefix ? nodes[n].prefix : nodes[n].exact;
+	}
+
+	// returns false if the same key was already added, the value is
+	// not replaced in this case
+	bool add(StringView key, index_t value, bool prefix)
+	{
+		index_t& slot = this->value(key, prefix);
+		if(slot != npos) return false;
+		slot = value;
+		return true;
+	}
+
+	result find(StringView path, captures_t& caps) const
+	{
+		result ret;
+		captures_t cur_caps;
+		walk(0, path, 0, cur_caps, ret, caps);
+		return ret;
+	}
+
+	result find(StringView path) const
+	{
+		captures_t caps;
+		return find(path, caps);
+	}
+
+	std::size_t nodes_count() const { return nodes.size(); }
+};
+
+} // namespace http_parser
@@ -0,0 +1,118 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace http_parser {
+
+namespace router_handle_details {
+
+// index of the calling thread, threads get sequential numbers
+inline std::size_t thread_index()
+{
+	static std::atomic<std::size_t> next{0};
+	thread_local const std::size_t index = next.fetch_add(1);
+	return index;
+}
+
+} // namespace router_handle_details
+
+// rcu like handle for a router: readers use an immutable snapshot
+// and never wait, a writer publishes a new snapshot and frees the
+// previous one after all the readers left it.
+// readers are counted in two slots, the slot is switched by the
+// writer so new readers don't prevent the old slot from draining.
+// each slot is sharded by thread: a reader writes only its own shard
+// cache line, the writer waits for all shards of the slot.
+template<typename Router>
+class router_handle final {
+	struct alignas(64) reader_counter {
+		std::atomic<std::size_t> value{0};
+	};
+
+	constexpr static std::size_t reader_shards = 32;
+
+	std::atomic<const Router*> current;
+	alignas(64) std::atomic<std::size_t> epoch{0};
+	mutable std::array<std::array<reader_counter, 2>, reader_shards> readers;
+	std::mutex writer;
+
+	void wait_readers(std::size_t slot)
+	{
+		for(auto& shard:readers)
+			while(shard[slot].value.load() != 0) std::this_thread::yield();
+	}
+
+	// waits for all readers which could see the previous snapshot
+	void synchronize()
+	{
+		for(int i=0;i<2;++i) {
+			std::size_t old = epoch.fetch_add(1);
+			wait_readers(old & 1);
+		}
+	}
+public:
+	router_handle(const router_handle&) =delete ;
+	router_handle& operator = (const router_handle&) =delete ;
+
+	explicit router_handle(std::unique_ptr<const Router> r)
+	    : current(r.release())
+	{
+	}
+
+	explicit router_handle(Router r)
+	    : router_handle(std::make_unique<const Router>(std::move(r)))
+	{
+	}
+
+	~router_handle()
+	{
+		delete current.load();
+	}
+
+	// calls fnc with the current snapshot, the snapshot stays alive
+	// until fnc returns. fnc can be called concurrently from any threads.
+	template<typename Functor>
+	decltype(auto) read(Functor&& fnc) const
+	{
+		auto& shard = readers[router_handle_details::thread_index() % reader_shards];
+		auto& counter = shard[epoch.load() & 1].value;
+		counter.fetch_add(1);
+		struct leave { std::atomic<std::size_t>& c; ~leave(){ c.fetch_sub(1); } } guard{counter};
+		return std::forward<Functor>(fnc)(*current.load());
+	}
+
+	template<typename... Args>
+	decltype(auto) operator()(Args&&... args) const
+	{
+		return read([&](const Router& r) -> decltype(auto) { return r(std::forward<Args>(args)...); });
+	}
+
+	// replaces the snapshot, waits for readers of the previous one
+	// (only the writer waits) and destroys it.
+	// publish can be called from several threads, they are serialized.
+	void publish(std::unique_ptr<const Router> r)
+	{
+		std::lock_guard lock(writer);
+		std::unique_ptr<const Router> old(current.exchange(r.release()));
+		synchronize();
+	}
+
+	void publish(Router r)
+	{
+		publish(std::make_unique<const Router>(std::move(r)));
+	}
+};
+
+} // namespace http_parser
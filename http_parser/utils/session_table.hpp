@@ -0,0 +1,143 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <cstdint>
+#include <utility>
+#include "factories.hpp"
+
+namespace http_parser {
+
+// open addressing hash table for sessions keyed by an integer
+// connection id: linear probing, erased slots are marked with
+// tombstones and dropped on rehash. the values are kept constructed
+// in all the slots (they are reset on erase), so Value should be
+// default constructible and move assignable.
+template<typename Key, typename Value, typename ContainerFactory = pmr_vector_factory>
+class session_table final {
+	enum class slot_state : std::uint8_t { empty, live, tombstone };
+public:
+	struct slot {
+		Key first{};
+		Value second{};
+		slot_state state = slot_state::empty;
+	};
+private:
+	using container_t = decltype(std::declval<ContainerFactory>().template operator()<slot>());
+
+	ContainerFactory factory;
+	container_t slots;
+	std::size_t live = 0;
+	std::size_t used = 0; // live and tombstones
+
+	static std::size_t hash(Key key)
+	{
+		auto h = static_cast<std::uint64_t>(key);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return static_cast<std::size_t>(h);
+	}
+
+	std::size_t mask() const { return slots.size() - 1; }
+
+	// the slot with the key or the empty one where the probe ended
+	std::size_t probe(Key key) const
+	{
+		std::size_t i = hash(key) & mask();
+		while(slots[i].state != slot_state::empty) {
+			if(slots[i].state == slot_state::live && slots[i].first == key) return i;
+			i = (i + 1) & mask();
+		}
+		return i;
+	}
+
+	void rehash(std::size_t size)
+	{
+		container_t old = std::move(slots);
+		slots = factory.template operator()<slot>();
+		slots.resize(size);
+		used = live;
+		for(auto& s:old) if(s.state == slot_state::live) {
+			std::size_t i = hash(s.first) & mask();
+			while(slots[i].state != slot_state::empty) i = (i + 1) & mask();
+			slots[i].first = s.first;
+			slots[i].second = std::move(s.second);
+			slots[i].state = slot_state::live;
+		}
+	}
+
+	template<typename Slot>
+	class basic_iterator {
+		Slot* cur;
+		Slot* end;
+		void skip() { while(cur != end && cur->state != slot_state::live) ++cur; }
+	public:
+		basic_iterator(Slot* c, Slot* e) : cur(c), end(e) { skip(); }
+		Slot& operator*() const { return *cur; }
+		Slot* operator->() const { return cur; }
+		basic_iterator& operator++() { ++cur; skip(); return *this; }
+		bool operator == (const basic_iterator& other) const { return cur == other.cur; }
+	};
+public:
+	using iterator = basic_iterator<slot>;
+	using const_iterator = basic_iterator<const slot>;
+
+	explicit session_table(ContainerFactory cf = ContainerFactory{})
+	    : factory(std::move(cf))
+	    , slots(factory.template operator()<slot>())
+	{
+	}
+
+	Value* find(Key key)
+	{
+		if(live == 0) return nullptr;
+		auto& s = slots[probe(key)];
+		return s.state == slot_state::live ? &s.second : nullptr;
+	}
+
+	// returns the value and true if it was created
+	std::pair<Value*, bool> try_emplace(Key key)
+	{
+		if(slots.size() <= (used + 1) * 2)
+			rehash(slots.size() <= (live + 1) * 4 ? (slots.empty() ? 16 : slots.size() * 2) : slots.size());
+		std::size_t i = hash(key) & mask();
+		std::size_t tomb = slots.size();
+		for(;slots[i].state != slot_state::empty;i = (i + 1) & mask()) {
+			if(slots[i].state == slot_state::live && slots[i].first == key) return { &slots[i].second, false };
+			if(slots[i].state == slot_state::tombstone && tomb == slots.size()) tomb = i;
+		}
+		if(tomb != slots.size()) i = tomb;
+		else ++used;
+		slots[i].first = key;
+		slots[i].state = slot_state::live;
+		++live;
+		return { &slots[i].second, true };
+	}
+
+	bool erase(Key key)
+	{
+		if(live == 0) return false;
+		auto& s = slots[probe(key)];
+		if(s.state != slot_state::live) return false;
+		s.second = Value{};
+		s.state = slot_state::tombstone;
+		--live;
+		return true;
+	}
+
+	std::size_t size() const { return live; }
+	bool empty() const { return live == 0; }
+
+	iterator begin() { return iterator(slots.data(), slots.data() + slots.size()); }
+	iterator end() { return iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+	const_iterator begin() const { return const_iterator(slots.data(), slots.data() + slots.size()); }
+	const_iterator end() const { return const_iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+};
+
+} // namespace http_parser
@@ -0,0 +1,85 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace http_parser {
+
+// sha-1 (rfc 3174), needed for the websocket handshake only: it is
+// not a secure hash. works in constant memory and can be constexpr.
+class sha1 final {
+public:
+	using digest_t = std::array<std::uint8_t, 20>;
+private:
+	std::array<std::uint32_t, 5> state{ 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+	std::array<std::uint8_t, 64> block{};
+	std::size_t block_size = 0;
+	std::uint64_t total = 0;
+
+	constexpr static std::uint32_t rotl(std::uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+	constexpr void process()
+	{
+		std::array<std::uint32_t, 80> w{};
+		for(std::size_t i=0;i<16;++i)
+			w[i] = (std::uint32_t(block[i*4]) << 24) | (std::uint32_t(block[i*4+1]) << 16)
+			     | (std::uint32_t(block[i*4+2]) << 8) | std::uint32_t(block[i*4+3]);
+		for(std::size_t i=16;i<80;++i) w[i] = rotl(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+
+		std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+		for(std::size_t i=0;i<80;++i) {
+			std::uint32_t f, k;
+			if(i < 20) { f = (b & c) | (~b & d); k = 0x5A827999u; }
+			else if(i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1u; }
+			else if(i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDCu; }
+			else { f = b ^ c ^ d; k = 0xCA62C1D6u; }
+			const std::uint32_t tmp = rotl(a, 5) + f + e + k + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = tmp;
+		}
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+		block_size = 0;
+	}
+public:
+	template<typename Char>
+	constexpr sha1& update(std::basic_string_view<Char> data)
+	{
+		static_assert(sizeof(Char) == 1);
+		for(auto c:data) {
+			block[block_size++] = static_cast<std::uint8_t>(c);
+			if(block_size == block.size()) process();
+		}
+		total += data.size();
+		return *this;
+	}
+
+	constexpr sha1& update(std::string_view data) { return update<char>(data); }
+
+	constexpr digest_t finish()
+	{
+		const std::uint64_t bits = total * 8;
+		block[block_size++] = 0x80;
+		if(56 < block_size) {
+			while(block_size < 64) block[block_size++] = 0;
+			process();
+		}
+		while(block_size < 56) block[block_size++] = 0;
+		for(int i=7;0<=i;--i) block[block_size++] = static_cast<std::uint8_t>(bits >> (i * 8));
+		process();
+
+		digest_t ret{};
+		for(std::size_t i=0;i<state.size();++i)
+			for(std::size_t j=0;j<4;++j)
+				ret[i*4+j] = static_cast<std::uint8_t>(state[i] >> (24 - j * 8));
+		return ret;
+	}
+};
+
+} // namespace http_parser
@@ -0,0 +1,207 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+#include "fixed_string.hpp"
+
+namespace http_parser {
+
+namespace static_router_details {
+
+constexpr std::uint32_t hash(std::string_view s, std::uint32_t seed)
+{
+	std::uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+	for(char c:s) {
+		h ^= (unsigned char)c;
+		h *= 16777619u;
+	}
+	return h ^ (h >> 15);
+}
+
+// first level: cheap, uses only length and first/last bytes
+constexpr std::uint32_t bucket_hash(std::string_view s)
+{
+	if(s.empty()) return 0;
+	return (std::uint32_t)s.size() * 31u + (unsigned char)s.front() + (unsigned char)s.back() * 7u;
+}
+
+// two level perfect hash (hash and displace): keys are split to buckets
+// by bucket_hash and for each bucket a seed is chosen so all the keys
+// get free slots in the table
+template<std::size_t N>
+struct perfect_hash {
+	constexpr static std::size_t buckets_count = N == 0 ? 1 : N;
+	constexpr static std::size_t table_size = N == 0 ? 1 : 2 * N;
+	constexpr static std::uint32_t max_seed = 1 << 16;
+
+	std::array<std::uint32_t, buckets_count> seeds{};
+	std::array<std::uint32_t, table_size> table{}; // index + 1
+
+	constexpr perfect_hash(const std::array<std::string_view, N>& keys)
+	{
+		std::array<std::size_t, buckets_count> sizes{};
+		for(auto& k:keys) ++sizes[bucket_hash(k) % buckets_count];
+		std::array<bool, buckets_count> done{};
+		for(std::size_t b=0;b<buckets_count;++b) {
+			std::size_t cur = 0;
+			for(std::size_t i=0;i<buckets_count;++i)
+				if(!done[i] && (done[cur] || sizes[cur] < sizes[i])) cur = i;
+			done[cur] = true;
+			if(sizes[cur] != 0) place_bucket(keys, cur);
+		}
+	}
+
+	constexpr void place_bucket(const std::array<std::string_view, N>& keys, std::size_t bucket)
+	{
+		for(std::uint32_t seed=1;seed<max_seed;++seed) {
+			std::array<std::uint32_t, table_size> test = table;
+			bool ok = true;
+			for(std::size_t i=0;ok && i<N;++i) {
+				if(bucket_hash(keys[i]) % buckets_count != bucket) continue;
+				auto slot = hash(keys[i], seed) % table_size;
+				ok = test[slot] == 0;
+				test[slot] = i + 1;
+			}
+			if(ok) {
+				table = test;
+				seeds[bucket] = seed;
+				return;
+			}
+		}
+		throw "cannot build perfect hash (maybe there are duplicated routes)";
+	}
+
+	constexpr std::size_t find(std::string_view key) const
+	{
+		auto seed = seeds[bucket_hash(key) % buckets_count];
+		if(seed == 0) return 0;
+		return table[hash(key, seed) % table_size];
+	}
+};
+
+template<std::size_t N>
+constexpr std::size_t count_prefix(const std::array<std::string_view, N>& routes)
+{
+	std::size_t ret = 0;
+	for(auto& r:routes) ret += !r.empty() && r.back() == '/';
+	return ret;
+}
+
+} // namespace static_router_details
+
+// route table known at compile time: exact routes are resolved with
+// perfect hash, prefix ones (ended with '/') are checked from the
+// longest to the shortest. nothing is computed at runtime.
+template<fixed_string... Routes>
+struct static_routes {
+	constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+	constexpr static std::size_t count = sizeof...(Routes);
+	constexpr static std::array<std::string_view, count> patterns{ Routes.view()... };
+
+	constexpr static bool is_prefix(std::size_t ind)
+	{
+		return !patterns[ind].empty() && patterns[ind].back() == '/';
+	}
+private:
+	constexpr static std::size_t prefix_count = static_router_details::count_prefix(patterns);
+	constexpr static std::size_t exact_count = count - prefix_count;
+
+	struct tables {
+		std::array<std::size_t, exact_count> exact{};
+		std::array<std::size_t, prefix_count> prefix{};
+		std::array<std::string_view, exact_count> exact_keys{};
+		std::uint64_t lengths = 0;
+		std::size_t max_length = 0;
+
+		constexpr tables()
+		{
+			std::size_t e=0, p=0;
+			for(std::size_t i=0;i<count;++i) {
+				if(is_prefix(i)) prefix[p++] = i;
+				else {
+					exact_keys[e] = patterns[i];
+					exact[e++] = i;
+					if(patterns[i].size() < 64) lengths |= std::uint64_t(1) << patterns[i].size();
+					if(max_length < patterns[i].size()) max_length = patterns[i].size();
+				}
+			}
+			for(std::size_t i=0;i<prefix_count;++i)
+				for(std::size_t j=i+1;j<prefix_count;++j)
+					if(patterns[prefix[i]].size() < patterns[prefix[j]].size())
+						std::swap(prefix[i], prefix[j]);
+		}
+	};
+
+	constexpr static tables tbl{};
+	constexpr static static_router_details::perfect_hash<exact_count> exact_hash{ tbl.exact_keys };
+
+	constexpr static std::size_t find_exact(std::string_view path)
+	{
+		if(tbl.max_length < path.size()) return npos;
+		if(path.size() < 64 && !(tbl.lengths & (std::uint64_t(1) << path.size()))) return npos;
+		std::size_t ind = exact_hash.find(path);
+		if(ind == 0 || tbl.exact_keys[ind-1] != path) return npos;
+		return tbl.exact[ind-1];
+	}
+public:
+	constexpr static std::size_t find(std::string_view path)
+	{
+		if constexpr (exact_count != 0) {
+			if(auto ret = find_exact(path); ret != npos) return ret;
+		}
+		for(std::size_t i=0;i<prefix_count;++i)
+			if(path.starts_with(patterns[tbl.prefix[i]])) return tbl.prefix[i];
+		return npos;
+	}
+};
+
+// the same as directory_router, but routes and handlers are fixed at
+// compile time: no allocation, no startup cost, handlers are inlined.
+// the handler receives the path (or the tail for prefix routes)
+// if it can.
+template<typename Routes, typename... Handlers>
+class static_router {
+	static_assert(Routes::count == sizeof...(Handlers), "each route should have a handler");
+	std::tuple<Handlers...> handlers;
+
+	template<std::size_t I>
+	void call(std::string_view path) const
+	{
+		auto& fnc = std::get<I>(handlers);
+		auto arg = Routes::is_prefix(I) ? path.substr(Routes::patterns[I].size()) : path;
+		if constexpr (requires{ fnc(arg); }) fnc(arg);
+		else fnc();
+	}
+public:
+	using routes = Routes;
+
+	constexpr explicit static_router(Handlers... h) : handlers(std::move(h)...) {}
+
+	bool operator()(std::string_view path) const
+	{
+		const std::size_t ind = Routes::find(path);
+		if(ind == Routes::npos) return false;
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			(void)((I == ind ? (call<I>(path), true) : false) || ...);
+		}(std::index_sequence_for<Handlers...>{});
+		return true;
+	}
+};
+
+template<fixed_string... Routes, typename... Handlers>
+constexpr auto make_static_router(Handlers&&... handlers)
+{
+	return static_router<static_routes<Routes...>, std::decay_t<Handlers>...>(std::forward<Handlers>(handlers)...);
+}
+
+} // namespace http_parser
@@ -0,0 +1,126 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <string_view>
+
+namespace http_parser {
+
+constexpr std::string_view reason_phrase(int code)
+{
+	using namespace std::literals;
+	switch(code) {
+	case 100: return "Continue"sv;
+	case 101: return "Switching Protocols"sv;
+	case 102: return "Processing"sv;
+	case 103: return "Early Hints"sv;
+	case 200: return "OK"sv;
+	case 201: return "Created"sv;
+	case 202: return "Accepted"sv;
+	case 203: return "Non-Authoritative Information"sv;
+	case 204: return "No Content"sv;
+	case 205: return "Reset Content"sv;
+	case 206: return "Partial Content"sv;
+	case 207: return "Multi-Status"sv;
+	case 208: return "Already Reported"sv;
+	case 226: return "IM Used"sv;
+	case 300: return "Multiple Choices"sv;
+	case 301: return "Moved Permanently"sv;
+	case 302: return "Found"sv;
+	case 303: return "See Other"sv;
+	case 304: return "Not Modified"sv;
+	case 305: return "Use Proxy"sv;
+	case 307: return "Temporary Redirect"sv;
+	case 308: return "Permanent Redirect"sv;
+	case 400: return "Bad Request"sv;
+	case 401: return "Unauthorized"sv;
+	case 402: return "Payment Required"sv;
+	case 403: return "Forbidden"sv;
+	case 404: return "Not Found"sv;
+	case 405: return "Method Not Allowed"sv;
+	case 406: return "Not Acceptable"sv;
+	case 407: return "Proxy Authentication Required"sv;
+	case 408: return "Request Timeout"sv;
+	case 409: return "Conflict"sv;
+	case 410: return "Gone"sv;
+	case 411: return "Length Required"sv;
+	case 412: return "Precondition Failed"sv;
+	case 413: return "Content Too Large"sv;
+	case 414: return "URI Too Long"sv;
+	case 415: return "Unsupported Media Type"sv;
+	case 416: return "Range Not Satisfiable"sv;
+	case 417: return "Expectation Failed"sv;
+	case 421: return "Misdirected Request"sv;
+	case 422: return "Unprocessable Content"sv;
+	case 423: return "Locked"sv;
+	case 424: return "Failed Dependency"sv;
+	case 425: return "Too Early"sv;
+	case 426: return "Upgrade Required"sv;
+	case 428: return "Precondition Required"sv;
+	case 429: return "Too Many Requests"sv;
+	case 431: return "Request Header Fields Too Large"sv;
+	case 451: return "Unavailable For Legal Reasons"sv;
+	case 500: return "Internal Server Error"sv;
+	case 501: return "Not Implemented"sv;
+	case 502: return "Bad Gateway"sv;
+	case 503: return "Service Unavailable"sv;
+	case 504: return "Gateway Timeout"sv;
+	case 505: return "HTTP Version Not Supported"sv;
+	case 506: return "Variant Also Negotiates"sv;
+	case 507: return "Insufficient Storage"sv;
+	case 508: return "Loop Detected"sv;
+	case 511: return "Network Authentication Required"sv;
+	}
+	return ""sv;
+}
+
+struct status_line {
+	std::array<char, 48> data;
+	std::size_t size;
+
+	constexpr std::string_view view() const { return std::string_view(data.data(), size); }
+};
+
+constexpr status_line make_status_line(int code)
+{
+	status_line ret{};
+	auto put = [&ret](char c){ ret.data[ret.size++] = c; };
+	for(char c:std::string_view("HTTP/1.1 ")) put(c);
+	put('0' + code / 100);
+	put('0' + code / 10 % 10);
+	put('0' + code % 10);
+	put(' ');
+	for(char c:reason_phrase(code)) put(c);
+	put('\r');
+	put('\n');
+	return ret;
+}
+
+constexpr int min_status_code = 100;
+constexpr int max_status_code = 599;
+
+inline constexpr auto status_lines = []{
+	std::array<status_line, max_status_code - min_status_code + 1> ret{};
+	for(int i=min_status_code;i<=max_status_code;++i)
+		ret[i - min_status_code] = make_status_line(i);
+	return ret;
+}();
+
+constexpr const status_line& find_status_line(int code)
+{
+	return status_lines[code - min_status_code];
+}
+
+// 1xx, 204 and 304 responses have no body (and no Content-Length)
+constexpr bool body_allowed(int code)
+{
+	return 200 <= code && code != 204 && code != 304;
+}
+
+} // namespace http_parser
@@ -0,0 +1,118 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include "factories.hpp"
+
+namespace http_parser {
+
+// hierarchical timer wheel: 4 levels by 64 slots, the level N slot
+// covers 64^N ticks. timers are not cancelled: the owner checks if
+// the fired timer is still actual and schedules it again if needed
+// (lazy expiration), so every operation is O(1) amortized.
+template<typename Id, typename ContainerFactory = pmr_vector_factory>
+class timer_wheel final {
+	constexpr static std::size_t slot_bits = 6;
+	constexpr static std::size_t slots_count = 1 << slot_bits;
+	constexpr static std::size_t levels_count = 4;
+	constexpr static std::uint64_t max_delay = (std::uint64_t(1) << (slot_bits * levels_count)) - 1;
+
+	struct entry {
+		Id id;
+		std::uint64_t deadline;
+	};
+	using slot_t = decltype(std::declval<ContainerFactory>().template operator()<entry>());
+
+	ContainerFactory factory;
+	std::array<std::array<slot_t, slots_count>, levels_count> levels;
+	std::uint64_t cur = 0;
+	std::size_t count = 0;
+
+	template<typename T, std::size_t... I, typename Make>
+	static std::array<T, sizeof...(I)> make_array(std::index_sequence<I...>, const Make& make)
+	{
+		return { ((void)I, make())... };
+	}
+
+	static auto make_levels(const ContainerFactory& f)
+	{
+		auto make_slots = [&f] {
+			return make_array<slot_t>(std::make_index_sequence<slots_count>{}, [&f]{ return f.template operator()<entry>(); });
+		};
+		return make_array<std::array<slot_t, slots_count>>(std::make_index_sequence<levels_count>{}, make_slots);
+	}
+
+	// earliest is cur on cascading (the level 0 slot for cur is not
+	// processed yet) and cur + 1 in other cases
+	void place(const entry& e, std::uint64_t earliest)
+	{
+		std::uint64_t deadline = e.deadline < earliest ? earliest : e.deadline;
+		if(cur + max_delay < deadline) deadline = cur + max_delay;
+		const std::uint64_t delta = deadline - cur;
+		std::size_t level = 0;
+		while(level + 1 < levels_count && (std::uint64_t(1) << (slot_bits * (level + 1))) <= delta) ++level;
+		levels[level][(deadline >> (slot_bits * level)) & (slots_count - 1)].push_back(entry{e.id, e.deadline});
+	}
+
+	template<typename Functor>
+	void step(Functor& fnc)
+	{
+		++cur;
+		for(std::size_t level=1;level<levels_count;++level) {
+			if(cur & ((std::uint64_t(1) << (slot_bits * level)) - 1)) break;
+			auto& slot = levels[level][(cur >> (slot_bits * level)) & (slots_count - 1)];
+			slot_t moved = std::move(slot);
+			slot = factory.template operator()<entry>();
+			for(auto& e:moved) place(e, cur);
+		}
+		auto& slot = levels[0][cur & (slots_count - 1)];
+		if(slot.empty()) return;
+		slot_t fired = std::move(slot);
+		slot = factory.template operator()<entry>();
+		count -= fired.size();
+		for(auto& e:fired) {
+			if(cur < e.deadline) { place(e, cur + 1); ++count; }
+			else fnc(e.id);
+		}
+	}
+public:
+	explicit timer_wheel(ContainerFactory cf = ContainerFactory{}, std::uint64_t start = 0)
+	    : factory(std::move(cf))
+	    , levels(make_levels(factory))
+	    , cur(start)
+	{
+	}
+
+	// the timer fires on advance to deadline or later tick
+	void schedule(Id id, std::uint64_t deadline)
+	{
+		place(entry{id, deadline}, cur + 1);
+		++count;
+	}
+
+	// fires all timers up to now, fnc(id) can schedule new timers
+	template<typename Functor>
+	void advance(std::uint64_t now, Functor&& fnc)
+	{
+		while(cur < now) {
+			if(count == 0) {
+				cur = now;
+				break;
+			}
+			step(fnc);
+		}
+	}
+
+	std::uint64_t now() const { return cur; }
+	std::size_t size() const { return count; }
+};
+
+} // namespace http_parser
@@ -0,0 +1,45 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <string_view>
+
+namespace http_parser {
+
+namespace tokens_details {
+
+constexpr char lower(char c)
+{
+	return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace tokens_details
+
+// checks the comma separated list of tokens (case insensitive),
+// "websocket" is found in "h2c, WebSocket/13" for example
+template<typename View>
+bool has_token(const View& list, std::string_view token)
+{
+	using tokens_details::lower;
+	std::size_t pos = 0;
+	const std::size_t size = list.size();
+	while(pos < size) {
+		while(pos < size && (list[pos] == ' ' || list[pos] == '\t' || list[pos] == ',')) ++pos;
+		std::size_t i = 0;
+		while(i < token.size() && pos + i < size && lower(list[pos + i]) == lower(token[i])) ++i;
+		if(i == token.size()) {
+			const std::size_t end = pos + i;
+			if(end == size || list[end] == ',' || list[end] == '/' || list[end] == ' ' || list[end] == '\t')
+				return true;
+		}
+		while(pos < size && list[pos] != ',') ++pos;
+	}
+	return false;
+}
+
+} // namespace http_parser
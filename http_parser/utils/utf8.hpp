@@ -0,0 +1,129 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace http_parser {
+
+namespace utf8_details {
+
+constexpr std::uint64_t high_bits = 0x8080808080808080ULL;
+
+// count of leading ascii bytes checked by 64 bit words
+inline std::size_t ascii_prefix(const unsigned char* data, std::size_t size)
+{
+	std::size_t i = 0;
+	for(;i + 32 <= size;i += 32) {
+		std::uint64_t w[4];
+		std::memcpy(w, data + i, sizeof(w));
+		if((w[0] | w[1] | w[2] | w[3]) & high_bits) break;
+	}
+	for(;i + 8 <= size;i += 8) {
+		std::uint64_t w;
+		std::memcpy(&w, data + i, sizeof(w));
+		if(w & high_bits) break;
+	}
+	while(i < size && data[i] < 0x80) ++i;
+	return i;
+}
+
+} // namespace utf8_details
+
+template<typename Char>
+bool is_ascii(const Char* data, std::size_t size)
+{
+	static_assert(sizeof(Char) == 1);
+	return utf8_details::ascii_prefix(reinterpret_cast<const unsigned char*>(data), size) == size;
+}
+
+template<typename Char>
+bool is_ascii(std::basic_string_view<Char> data) { return is_ascii(data.data(), data.size()); }
+
+inline bool is_ascii(std::string_view data) { return is_ascii(data.data(), data.size()); }
+
+// incremental utf-8 validator (rfc 3629: no overlong forms, surrogates
+// and code points above U+10FFFF): a sequence can be split between
+// update() calls. ascii runs are skipped by words.
+class utf8_validator final {
+	std::uint8_t need = 0; // continuation bytes left
+	std::uint8_t lo = 0x80, hi = 0xBF; // range of the next continuation byte
+	bool bad = false;
+
+	bool start(unsigned char b)
+	{
+		lo = 0x80;
+		hi = 0xBF;
+		if(b < 0xC2) return false;
+		if(b < 0xE0) need = 1;
+		else if(b < 0xF0) {
+			need = 2;
+			if(b == 0xE0) lo = 0xA0;
+			else if(b == 0xED) hi = 0x9F;
+		}
+		else if(b < 0xF5) {
+			need = 3;
+			if(b == 0xF0) lo = 0x90;
+			else if(b == 0xF4) hi = 0x8F;
+		}
+		else return false;
+		return true;
+	}
+public:
+	// returns false if the data seen so far is not valid
+	template<typename Char>
+	bool update(const Char* ptr, std::size_t size)
+	{
+		static_assert(sizeof(Char) == 1);
+		auto* data = reinterpret_cast<const unsigned char*>(ptr);
+		std::size_t i = 0;
+		while(!bad && i < size) {
+			if(need == 0) {
+				i += utf8_details::ascii_prefix(data + i, size - i);
+				if(i == size) break;
+				bad = !start(data[i++]);
+				continue;
+			}
+			const unsigned char b = data[i++];
+			if(b < lo || hi < b) bad = true;
+			else {
+				lo = 0x80;
+				hi = 0xBF;
+				--need;
+			}
+		}
+		return !bad;
+	}
+
+	template<typename Char>
+	bool update(std::basic_string_view<Char> data) { return update(data.data(), data.size()); }
+	bool update(std::string_view data) { return update(data.data(), data.size()); }
+
+	bool valid() const { return !bad; }
+	// the data is valid and has no incomplete sequence at the end
+	bool complete() const { return !bad && need == 0; }
+
+	void reset()
+	{
+		need = 0;
+		lo = 0x80;
+		hi = 0xBF;
+		bad = false;
+	}
+};
+
+inline bool is_valid_utf8(std::string_view data)
+{
+	utf8_validator v;
+	v.update(data);
+	return v.complete();
+}
+
+} // namespace http_parser
@@ -0,0 +1,95 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace http_parser::websocket {
+
+enum class opcode : std::uint8_t {
+	continuation = 0x0,
+	text = 0x1,
+	binary = 0x2,
+	close = 0x8,
+	ping = 0x9,
+	pong = 0xA
+};
+
+constexpr bool is_control(opcode op) { return static_cast<std::uint8_t>(op) & 0x8; }
+
+constexpr bool is_known(opcode op)
+{
+	switch(op) {
+	case opcode::continuation:
+	case opcode::text:
+	case opcode::binary:
+	case opcode::close:
+	case opcode::ping:
+	case opcode::pong:
+		return true;
+	}
+	return false;
+}
+
+// rfc 6455 section 7.4.1
+namespace close_codes {
+constexpr std::uint16_t normal = 1000;
+constexpr std::uint16_t going_away = 1001;
+constexpr std::uint16_t protocol_error = 1002;
+constexpr std::uint16_t unsupported_data = 1003;
+constexpr std::uint16_t invalid_payload = 1007;
+constexpr std::uint16_t policy_violation = 1008;
+constexpr std::uint16_t message_too_big = 1009;
+constexpr std::uint16_t internal_error = 1011;
+} // namespace close_codes
+
+constexpr std::size_t max_control_payload = 125;
+constexpr std::size_t max_frame_header_size = 14;
+
+using masking_key = std::array<unsigned char, 4>;
+
+struct frame_header {
+	bool fin = false;
+	opcode op = opcode::continuation;
+	// opcode of the message the frame belongs to (text or binary for
+	// continuation frames, the same as op for the rest)
+	opcode message_op = opcode::continuation;
+	bool masked = false;
+	masking_key mask{};
+	std::uint64_t payload_size = 0;
+};
+
+// xors data with the key in place, offset is the position of data in
+// the frame payload. works by 64 bit words: the key period (4) divides
+// the word size so one prepared word fits all the data.
+inline void unmask(unsigned char* data, std::size_t size, const masking_key& key, std::uint64_t offset = 0)
+{
+	std::array<unsigned char, 8> word_key;
+	for(std::size_t i=0;i<word_key.size();++i) word_key[i] = key[(offset + i) & 3];
+	std::uint64_t k64;
+	std::memcpy(&k64, word_key.data(), sizeof(k64));
+
+	std::size_t i = 0;
+	for(;i + 32 <= size;i += 32) {
+		std::uint64_t w[4];
+		std::memcpy(w, data + i, sizeof(w));
+		w[0] ^= k64; w[1] ^= k64; w[2] ^= k64; w[3] ^= k64;
+		std::memcpy(data + i, w, sizeof(w));
+	}
+	for(;i + 8 <= size;i += 8) {
+		std::uint64_t w;
+		std::memcpy(&w, data + i, sizeof(w));
+		w ^= k64;
+		std::memcpy(data + i, &w, sizeof(w));
+	}
+	for(;i < size;++i) data[i] ^= word_key[i & 7];
+}
+
+} // namespace http_parser::websocket
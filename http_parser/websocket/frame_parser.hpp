@@ -0,0 +1,210 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <span>
+#include <limits>
+#include "frame.hpp"
+#include "../utils/utf8.hpp"
+
+namespace http_parser::websocket {
+
+enum class frame_error {
+	none,
+	reserved_bits,
+	unknown_opcode,
+	control_too_big,
+	control_fragmented,
+	unexpected_continuation,
+	expected_continuation,
+	not_masked,
+	wrong_size,
+	too_big,
+	invalid_utf8
+};
+
+// streaming rfc 6455 frame parser. the data is unmasked in place and
+// the payload is passed to the handler as views of the input, a frame
+// can be passed by several pieces if it comes by parts. the header
+// parts are kept inside so all input is always consumed.
+// control frames can be placed between fragments of a message.
+// optionally text messages and close reasons are checked to be valid
+// utf-8, the check goes across fragments.
+template<typename Char = char>
+class frame_parser final {
+	enum class state_t { header, payload, error };
+
+	std::array<unsigned char, max_frame_header_size> hdr_buf{};
+	std::size_t hdr_size = 0;
+	frame_header cur;
+	std::uint64_t payload_pos = 0;
+	opcode message_op = opcode::continuation;
+	bool in_message = false;
+	state_t state = state_t::header;
+	frame_error err = frame_error::none;
+
+	bool require_mask;
+	std::uint64_t max_payload;
+	bool check_utf8;
+	utf8_validator text_utf8;
+	utf8_validator close_utf8;
+
+	bool fail(frame_error e)
+	{
+		err = e;
+		state = state_t::error;
+		return false;
+	}
+
+	std::size_t header_size() const
+	{
+		if(hdr_size < 2) return 2;
+		std::size_t ret = 2 + ((hdr_buf[1] & 0x80) ? 4 : 0);
+		const auto len = hdr_buf[1] & 0x7F;
+		if(len == 126) ret += 2;
+		else if(len == 127) ret += 8;
+		return ret;
+	}
+
+	bool decode_header()
+	{
+		const unsigned char b0 = hdr_buf[0], b1 = hdr_buf[1];
+		if(b0 & 0x70) return fail(frame_error::reserved_bits);
+		cur.fin = b0 & 0x80;
+		cur.op = static_cast<opcode>(b0 & 0x0F);
+		cur.masked = b1 & 0x80;
+		if(!is_known(cur.op)) return fail(frame_error::unknown_opcode);
+		if(require_mask && !cur.masked) return fail(frame_error::not_masked);
+
+		std::size_t pos = 2;
+		cur.payload_size = b1 & 0x7F;
+		if(cur.payload_size == 126) {
+			cur.payload_size = (std::uint64_t(hdr_buf[2]) << 8) | hdr_buf[3];
+			pos += 2;
+		} else if(cur.payload_size == 127) {
+			cur.payload_size = 0;
+			for(std::size_t i=0;i<8;++i) cur.payload_size = (cur.payload_size << 8) | hdr_buf[2+i];
+			if(cur.payload_size >> 63) return fail(frame_error::wrong_size);
+			pos += 8;
+		}
+		if(cur.masked) for(std::size_t i=0;i<4;++i) cur.mask[i] = hdr_buf[pos+i];
+
+		if(is_control(cur.op)) {
+			if(!cur.fin) return fail(frame_error::control_fragmented);
+			if(max_control_payload < cur.payload_size) return fail(frame_error::control_too_big);
+			if(cur.op == opcode::close && cur.payload_size == 1) return fail(frame_error::wrong_size);
+			close_utf8.reset();
+			cur.message_op = cur.op;
+		} else {
+			if(cur.op == opcode::continuation) {
+				if(!in_message) return fail(frame_error::unexpected_continuation);
+			} else {
+				if(in_message) return fail(frame_error::expected_continuation);
+				message_op = cur.op;
+				text_utf8.reset();
+			}
+			in_message = !cur.fin;
+			cur.message_op = message_op;
+		}
+		if(max_payload < cur.payload_size) return fail(frame_error::too_big);
+		payload_pos = 0;
+		state = state_t::payload;
+		return true;
+	}
+
+	// the close frame payload is 2 bytes of code and the reason
+	bool valid_utf8(std::span<Char> payload, bool frame_end)
+	{
+		if(cur.message_op == opcode::text) {
+			if(!text_utf8.update(payload.data(), payload.size())) return false;
+			return !frame_end || !cur.fin || text_utf8.complete();
+		}
+		if(cur.op == opcode::close) {
+			const std::size_t skip = payload_pos < 2 ? static_cast<std::size_t>(2 - payload_pos) : 0;
+			if(skip < payload.size() && !close_utf8.update(payload.data() + skip, payload.size() - skip)) return false;
+			return !frame_end || close_utf8.complete();
+		}
+		return true;
+	}
+public:
+	frame_parser() : frame_parser(true) {}
+
+	explicit frame_parser(
+	          bool require_mask
+	        , std::uint64_t max_payload = std::numeric_limits<std::uint64_t>::max()
+	        , bool validate_utf8 = false)
+	    : require_mask(require_mask)
+	    , max_payload(max_payload)
+	    , check_utf8(validate_utf8)
+	{}
+
+	// handler(const frame_header&, std::span<Char> payload, bool frame_end)
+	// returns consumed size, it is less than data.size() only on error
+	template<typename Handler>
+	std::size_t operator()(std::span<Char> data, Handler&& handler)
+	{
+		std::size_t pos = 0;
+		while(state != state_t::error) {
+			if(state == state_t::header) {
+				if(pos == data.size()) break;
+				std::size_t need = header_size();
+				while(hdr_size < need && pos < data.size()) {
+					hdr_buf[hdr_size++] = static_cast<unsigned char>(data[pos++]);
+					need = header_size();
+				}
+				if(hdr_size < need) break;
+				hdr_size = 0;
+				if(!decode_header()) return pos;
+			}
+			const std::uint64_t left = cur.payload_size - payload_pos;
+			const std::size_t avail = data.size() - pos;
+			const std::size_t piece = left < avail ? static_cast<std::size_t>(left) : avail;
+			if(piece == 0 && left != 0) break;
+			auto payload = data.subspan(pos, piece);
+			if(cur.masked) unmask(reinterpret_cast<unsigned char*>(payload.data()), piece, cur.mask, payload_pos);
+			const bool frame_end = payload_pos + piece == cur.payload_size;
+			if(check_utf8 && !valid_utf8(payload, frame_end)) {
+				fail(frame_error::invalid_utf8);
+				return pos;
+			}
+			payload_pos += piece;
+			pos += piece;
+			if(frame_end) state = state_t::header;
+			handler(static_cast<const frame_header&>(cur), payload, frame_end);
+		}
+		return pos;
+	}
+
+	bool failed() const { return state == state_t::error; }
+	frame_error error() const { return err; }
+
+	// the code for close frame in reply to the error
+	std::uint16_t close_code() const
+	{
+		switch(err) {
+		case frame_error::none: return close_codes::normal;
+		case frame_error::too_big: return close_codes::message_too_big;
+		case frame_error::invalid_utf8: return close_codes::invalid_payload;
+		default: return close_codes::protocol_error;
+		}
+	}
+
+	// a message is started but its last fragment isn't received yet
+	bool in_fragmented_message() const { return in_message; }
+
+	void reset()
+	{
+		hdr_size = 0;
+		payload_pos = 0;
+		in_message = false;
+		state = state_t::header;
+		err = frame_error::none;
+	}
+};
+
+} // namespace http_parser::websocket
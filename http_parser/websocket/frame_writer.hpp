@@ -0,0 +1,124 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <span>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include "frame.hpp"
+#include "../generator.hpp"
+
+namespace http_parser::websocket {
+
+constexpr std::size_t frame_header_size(std::uint64_t payload_size, bool masked = false)
+{
+	std::size_t ret = masked ? 6 : 2;
+	if(payload_size <= 125) return ret;
+	return ret + (payload_size <= 0xFFFF ? 2 : 8);
+}
+
+// writes the header into out (frame_header_size() bytes), returns its size
+constexpr std::size_t write_frame_header(unsigned char* out, opcode op, bool fin, std::uint64_t payload_size, const masking_key* mask = nullptr)
+{
+	std::size_t pos = 0;
+	out[pos++] = static_cast<unsigned char>((fin ? 0x80 : 0) | static_cast<std::uint8_t>(op));
+	const unsigned char mask_bit = mask ? 0x80 : 0;
+	if(payload_size <= 125) out[pos++] = mask_bit | static_cast<unsigned char>(payload_size);
+	else if(payload_size <= 0xFFFF) {
+		out[pos++] = mask_bit | 126;
+		out[pos++] = static_cast<unsigned char>(payload_size >> 8);
+		out[pos++] = static_cast<unsigned char>(payload_size);
+	} else {
+		out[pos++] = mask_bit | 127;
+		for(int i=7;0<=i;--i) out[pos++] = static_cast<unsigned char>(payload_size >> (8*i));
+	}
+	if(mask) for(auto k:*mask) out[pos++] = k;
+	return pos;
+}
+
+// the payload is placed in buf after headroom bytes, the header is
+// written just before it. returns the whole frame (a part of buf).
+// max_frame_header_size of headroom is always enough.
+// with mask the payload is masked in place (client side).
+template<typename Char>
+std::span<Char> frame_in_headroom(std::span<Char> buf, std::size_t headroom, opcode op, bool fin = true, const masking_key* mask = nullptr)
+{
+	static_assert(sizeof(Char) == 1);
+	if(buf.size() < headroom) throw std::out_of_range("headroom is bigger than the buffer");
+	const std::size_t payload_size = buf.size() - headroom;
+	const std::size_t hsize = frame_header_size(payload_size, mask);
+	if(headroom < hsize) throw std::out_of_range("not enough headroom for websocket frame header");
+	auto* payload = reinterpret_cast<unsigned char*>(buf.data() + headroom);
+	write_frame_header(payload - hsize, op, fin, payload_size, mask);
+	if(mask) unmask(payload, payload_size, *mask);
+	return buf.subspan(headroom - hsize);
+}
+
+// frame as header and payload buffers: the header is stored inside,
+// the payload is the caller's memory and is not copied.
+struct frame_buffers {
+	std::array<unsigned char, max_frame_header_size> header_bytes{};
+	std::size_t header_size = 0;
+	output_buffer payload{ nullptr, 0 };
+
+	output_buffer header() const { return output_buffer{ header_bytes.data(), header_size }; }
+	std::size_t total_size() const { return header_size + payload.size; }
+	std::size_t size() const { return payload.size == 0 ? 1 : 2; }
+
+	// fills iovec (or any {ptr, len} aggregate) array, returns count
+	template<typename IoVec, std::size_t Extent>
+	std::size_t fill(std::span<IoVec, Extent> out) const
+	{
+		if(out.size() < size())
+			throw std::out_of_range("not enough space for frame buffers");
+		out[0] = IoVec{ const_cast<unsigned char*>(header_bytes.data()), header_size };
+		if(payload.size != 0) out[1] = IoVec{ const_cast<void*>(payload.data), payload.size };
+		return size();
+	}
+};
+
+// splits a server message to frames of max_payload size at most,
+// the first frame has the message opcode, the rest are continuations.
+// an empty message is one empty frame.
+template<typename Char = char>
+class frame_writer final {
+	static_assert(sizeof(Char) == 1);
+	opcode op;
+	std::span<const Char> payload;
+	std::size_t max_payload;
+	std::size_t pos = 0;
+	bool done = false;
+public:
+	frame_writer(opcode op, std::span<const Char> payload, std::size_t max_payload = std::numeric_limits<std::size_t>::max())
+	    : op(op)
+	    , payload(payload)
+	    , max_payload(max_payload == 0 ? 1 : max_payload)
+	{
+		if(is_control(op) && (max_control_payload < payload.size() || this->max_payload < payload.size()))
+			throw std::out_of_range("control frame cannot be fragmented");
+	}
+
+	std::optional<frame_buffers> next()
+	{
+		if(done) return std::nullopt;
+		const std::size_t left = payload.size() - pos;
+		const std::size_t size = left < max_payload ? left : max_payload;
+		const bool fin = pos + size == payload.size();
+		frame_buffers ret;
+		ret.header_size = write_frame_header(ret.header_bytes.data(), pos == 0 ? op : opcode::continuation, fin, size);
+		ret.payload = output_buffer{ payload.data() + pos, size };
+		pos += size;
+		done = fin;
+		return ret;
+	}
+
+	bool finished() const { return done; }
+};
+
+} // namespace http_parser::websocket
@@ -0,0 +1,41 @@
+#pragma once
+
+/*************************************************************************
+ * Copyright © 2022 Hudyaev Alexy <hudyaev.alexy@gmail.com>
+ * This file is part of http_parser.
+ * Distributed under the MIT License.
+ * See accompanying file LICENSE (at the root of this repository)
+ *************************************************************************/
+
+#include <array>
+#include <string_view>
+#include "../utils/sha1.hpp"
+#include "../utils/base64.hpp"
+
+namespace http_parser::websocket {
+
+constexpr std::string_view accept_guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+constexpr std::string_view supported_version = "13";
+// base64 of 16 bytes
+constexpr std::size_t client_key_size = 24;
+
+struct accept_key {
+	std::array<char, base64_size(20)> value{};
+	constexpr std::string_view view() const { return std::string_view(value.data(), value.size()); }
+};
+
+// Sec-WebSocket-Accept value for Sec-WebSocket-Key
+constexpr accept_key make_accept_key(std::string_view client_key)
+{
+	auto digest = sha1{}.update(client_key).update(accept_guid).finish();
+	accept_key ret;
+	base64_encode(digest, ret.value.data());
+	return ret;
+}
+
+constexpr bool valid_client_key(std::string_view key)
+{
+	return key.size() == client_key_size && base64_decoded_size(key) == 16;
+}
+
+} // namespace http_parser::websocket
@@ -129,8 +129,143 @@ BOOST_FIXTURE_TEST_CASE(on_error, fixture)
 	BOOST_TEST(t1_e_count == 1);
 	BOOST_TEST(t2_e_count == 1);
 }
+BOOST_FIXTURE_TEST_CASE(sticky, fixture)
+{
+	std::size_t tests = 0;
+	t1.on_test_ = [&tests](const auto& head) { ++tests; return head.head().code == 10; };
+	acc.add(std::shared_ptr<test_acc>(&t1, [](auto*){}));
+	acc.add(std::move(t2));
+
+	head.head().code = 10;
+	acc.on_head(head);
+	BOOST_TEST(tests == 1);
+	BOOST_TEST(t1_h_count == 1);
+
+	head.head().code = 20;
+	acc.on_message(head, data_view, 10);
+	acc.on_message(head, data_view, 0);
+	acc.on_error(head, data_view);
+	BOOST_TEST(tests == 1);
+	BOOST_TEST(t1_m_count == 2);
+	BOOST_TEST(t2_m_count == 0);
+	BOOST_TEST(t1_e_count == 1);
+
+	acc.on_head(head);
+	acc.on_message(head, data_view, 0);
+	BOOST_TEST(tests == 2);
+	BOOST_TEST(t2_h_count == 1);
+	BOOST_TEST(t2_m_count == 1);
+
+	test_acc::head_t other(&data, container_factory);
+	other.head().code = 10;
+	acc.on_message(other, data_view, 0);
+	BOOST_TEST(t1_m_count == 3);
+}
 BOOST_AUTO_TEST_SUITE_END() // chain
 
+BOOST_AUTO_TEST_SUITE(keys)
+using req_parser_t = http_parser::pmr_str::http1_req_parser<>;
+using req_acc_t = req_parser_t::chain_acceptor_type;
+struct keyed_acc : req_acc_t {
+	std::optional<http_parser::acceptor_key> key;
+	std::size_t* tests;
+	std::size_t* heads;
+	keyed_acc(std::optional<http_parser::acceptor_key> k, std::size_t* t, std::size_t* h) : key(k), tests(t), heads(h) {}
+	std::optional<http_parser::acceptor_key> selection_key() const override { return key; }
+	bool can_accept(const head_t& head) override { ++*tests; return true; }
+	void on_head(const head_t& head) override { ++*heads; }
+};
+BOOST_AUTO_TEST_CASE(indexed)
+{
+	using http_parser::methods;
+	req_acc_t acc;
+	std::size_t tests = 0, ws = 0, connect = 0, api = 0, other = 0;
+	acc.add(keyed_acc({{.upgrade="websocket"}}, &tests, &ws));
+	acc.add(keyed_acc({{.method=methods::connect}}, &tests, &connect));
+	acc.add(keyed_acc({{.method=methods::get, .path_prefix="/api/"}}, &tests, &api));
+	acc.add(keyed_acc(std::nullopt, &tests, &other));
+
+	std::pmr::string data;
+	http_parser::pmr_vector_factory factory;
+	auto send = [&](std::string_view req, std::string_view upgrade) {
+		data = req;
+		req_acc_t::head_t head(&data, factory);
+		head.head().method(0, req.find(' '));
+		head.head().url(req.find(' ') + 1, req.size() - req.find(' ') - 1);
+		if(!upgrade.empty()) {
+			auto pos = data.size();
+			data += "Upgrade";
+			data += upgrade;
+			head.headers().add_header_name(pos, 7);
+			head.headers().last_header_value(pos + 7, upgrade.size());
+		}
+		acc.on_head(head);
+	};
+
+	send("GET /api/items", "");
+	BOOST_TEST(api == 1);
+	send("GET /chat", "h2c, WebSocket");
+	BOOST_TEST(ws == 1);
+	send("CONNECT host:443", "");
+	BOOST_TEST(connect == 1);
+	BOOST_TEST(tests == 0);
+
+	send("POST /api/items", "");
+	send("GET /chat", "websocket2");
+	BOOST_TEST(other == 2);
+	BOOST_TEST(tests == 2);
+	BOOST_TEST(api == 1);
+	BOOST_TEST(ws == 1);
+}
+BOOST_AUTO_TEST_SUITE_END() // keys
+
+BOOST_AUTO_TEST_SUITE(static_chain)
+struct post_acc {
+	std::size_t heads = 0, messages = 0, errors = 0;
+	bool can_accept(const parser_t::message_t& head) { return head.head().code == 10; }
+	void on_head(const parser_t::message_t& head) { ++heads; }
+	void on_message(const parser_t::message_t& head, const parser_t::data_view_t& body, std::size_t tail) { ++messages; }
+	void on_error(const parser_t::message_t& head, const parser_t::data_view_t& body) { ++errors; }
+};
+struct any_acc {
+	std::size_t heads = 0, messages = 0;
+	void on_error(const parser_t::message_t& head, const parser_t::data_view_t& body) {}
+	void on_head(const parser_t::message_t& head) { heads += 10; }
+	void on_message(const parser_t::message_t& head, const parser_t::data_view_t& body, std::size_t tail) { messages += 10; }
+};
+BOOST_AUTO_TEST_CASE(dispatch)
+{
+	parser_t::static_chain_acceptor_type<post_acc, any_acc> acc;
+	static_assert(decltype(acc)::chain_size() == 2);
+
+	std::pmr::string data;
+	http_parser::pmr_vector_factory factory;
+	parser_t::message_t head(&data, factory);
+	parser_t::data_view_t body(&data);
+
+	head.head().code = 10;
+	acc.on_head(head);
+	head.head().code = 20;
+	acc.on_message(head, body, 0);
+	acc.on_error(head, body);
+	BOOST_TEST(acc.get<0>().heads == 1);
+	BOOST_TEST(acc.get<0>().messages == 1);
+	BOOST_TEST(acc.get<0>().errors == 1);
+	BOOST_TEST(acc.get<1>().heads == 0);
+
+	acc.on_head(head);
+	acc.on_message(head, body, 0);
+	BOOST_TEST(acc.get<1>().heads == 10);
+	BOOST_TEST(acc.get<1>().messages == 10);
+	BOOST_TEST(acc.can_accept(head));
+
+	parser_t prs(&acc);
+	prs("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabc"sv);
+	BOOST_TEST(acc.get<1>().heads == 20);
+	BOOST_TEST(acc.get<1>().messages == 20);
+}
+BOOST_AUTO_TEST_SUITE_END() // static_chain
+
 BOOST_AUTO_TEST_SUITE(ws)
 using parser_t = http_parser::pmr_str::http1_req_parser<>;
 template<typename T>
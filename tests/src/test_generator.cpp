@@ -1,11 +1,24 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE generator
 
+#include <chrono>
 #include <boost/test/unit_test.hpp>
 #include <http_parser/generator.hpp>
 #include <http_parser/utils/factories.hpp>
+#include <http_parser/generators/chunk_coalescer.hpp>
+#include <http_parser/generators/response_batch.hpp>
+#include <http_parser/generators/static_response.hpp>
 
 using namespace std::literals;
+namespace utf = boost::unit_test;
+
+constexpr bool enable_speed_tests =
+        #ifdef  ENABLE_SPEED_TESTS
+        true
+        #else
+        false
+        #endif
+        ;
 
 void check_string(std::string_view result, std::string_view right)
 {
@@ -100,6 +113,41 @@ BOOST_AUTO_TEST_CASE(memory)
 	BOOST_TEST(body.c_str() == right_body.c_str());
 	check_string(body, right_body);
 }
+BOOST_AUTO_TEST_CASE(reset)
+{
+	struct counting_resource : std::pmr::memory_resource {
+		std::size_t count = 0;
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+			++count;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	} mem;
+
+	request_generator gen(http_parser::pmr_string_factory{&mem});
+	std::array<char, 256> buf;
+	gen.method(http_parser::methods::post).uri("http://g.c/long/path/for/allocation")
+	   .header("User-Agent", "test agent with long name").make_chunked();
+	BOOST_TEST(gen.body_to(buf, "a"sv) != 0);
+	BOOST_TEST(gen.chunked());
+
+	std::size_t allocated = mem.count;
+	gen.reset();
+	BOOST_TEST(gen.chunked() == false);
+	gen.response(200).header("Server", "test server with long name");
+	std::size_t size = gen.body_to(buf, "ok"sv);
+	BOOST_TEST(mem.count == allocated);
+	BOOST_TEST(std::string_view(buf.data(), size) ==
+	           "HTTP/1.1 200 OK\r\nServer: test server with long name\r\nContent-Length: 2\r\n\r\nok"sv);
+
+	gen.reset().uri("http://g.c/p");
+	BOOST_TEST(gen.body(""sv) == "GET /p HTTP/1.1\r\nHost: g.c\r\n\r\n"sv);
+}
 BOOST_AUTO_TEST_CASE(just_body_size)
 {
 	request_generator gen;
@@ -145,6 +193,144 @@ BOOST_AUTO_TEST_CASE(body_afetr_and_end)
 	BOOST_TEST(gen.body(""sv) == "0\r\n\r\n"sv);
 }
 BOOST_AUTO_TEST_SUITE_END() // chunked
+BOOST_AUTO_TEST_SUITE(gather)
+struct io_vec {
+	void* base;
+	std::size_t len;
+};
+std::string join(const auto& out)
+{
+	std::string ret;
+	for(std::size_t i=0;i<out.size();++i)
+		ret.append((const char*)out[i].data, out[i].size);
+	return ret;
+}
+BOOST_AUTO_TEST_CASE(simple)
+{
+	using namespace http_parser;
+	request_generator gen;
+	gen.response(200, "OK").header("Server", "t");
+	std::string body = "content";
+	auto out = gen.gather_body(std::string_view(body));
+	BOOST_TEST(out.size() == 2);
+	BOOST_TEST(out[1].data == (const void*)body.data());
+	BOOST_TEST(out.total_size() == 56);
+	BOOST_TEST(join(out) == "HTTP/1.1 200 OK\r\nServer: t\r\nContent-Length: 7\r\n\r\ncontent"sv);
+
+	std::array<io_vec, 4> vecs;
+	BOOST_TEST(out.fill(std::span(vecs)) == 2);
+	BOOST_TEST(vecs[1].base == (void*)body.data());
+	BOOST_TEST(vecs[1].len == 7);
+	std::array<io_vec, 1> small;
+	BOOST_CHECK_THROW(out.fill(std::span(small)), std::out_of_range);
+}
+BOOST_AUTO_TEST_CASE(segments)
+{
+	request_generator gen;
+	gen.response(200, "OK");
+	std::array segs{ "ab"sv, ""sv, "cde"sv };
+	auto out = gen.gather_body(std::span<const std::string_view>(segs));
+	BOOST_TEST(out.size() == 3);
+	BOOST_TEST(join(out) == "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nabcde"sv);
+	BOOST_TEST(join(gen.gather_body(""sv)) == "HTTP/1.1 200 OK\r\n\r\n"sv);
+	BOOST_CHECK_THROW(gen.gather_body<2>(std::span<const std::string_view>(segs)), std::out_of_range);
+}
+BOOST_AUTO_TEST_CASE(chunked)
+{
+	request_generator gen;
+	gen.uri("http://g.c/p/a"sv).make_chunked();
+	std::array segs{ "ab"sv, "cde"sv };
+	auto out = gen.gather_body(std::span<const std::string_view>(segs));
+	BOOST_TEST(out.size() == 4);
+	BOOST_TEST(join(out) == "GET /p/a HTTP/1.1\r\n"
+	           "Host: g.c\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nabcde\r\n"sv);
+	BOOST_TEST(join(gen.gather_body("test"sv)) == "4\r\ntest\r\n"sv);
+	BOOST_TEST(join(gen.gather_body(""sv)) == "0\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(file)
+{
+	request_generator gen;
+	gen.response(200).header("Content-Type", "image/png");
+	auto out = gen.body(http_parser::file_range{ 7, 100, 1024 });
+	BOOST_TEST(out.file.fd == 7);
+	BOOST_TEST(out.file.offset == 100);
+	BOOST_TEST(out.file.size == 1024);
+	BOOST_TEST(std::string_view((const char*)out.head().data, out.head().size) ==
+	           "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 1024\r\n\r\n"sv);
+	BOOST_TEST(out.tail().size == 0);
+
+	gen.make_chunked();
+	out = gen.body(http_parser::file_range{ 7, 0, 16 });
+	BOOST_TEST(std::string_view((const char*)out.head().data, out.head().size) ==
+	           "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nTransfer-Encoding: chunked\r\n\r\n10\r\n"sv);
+	BOOST_TEST(std::string_view((const char*)out.tail().data, out.tail().size) == "\r\n"sv);
+	out = gen.body(http_parser::file_range{ 7, 16, 1 });
+	BOOST_TEST(std::string_view((const char*)out.head().data, out.head().size) == "1\r\n"sv);
+}
+BOOST_AUTO_TEST_SUITE_END() // gather
+BOOST_AUTO_TEST_SUITE(to_span)
+BOOST_AUTO_TEST_CASE(simple)
+{
+	request_generator gen;
+	gen.response(200, "OK").header("Server", "t");
+	std::array<char, 128> buf;
+	auto right = "HTTP/1.1 200 OK\r\nServer: t\r\nContent-Length: 2\r\n\r\nok"sv;
+	std::size_t size = gen.body_to(std::span(buf).first(10), "ok"sv);
+	BOOST_TEST(size == right.size());
+	size = gen.body_to(buf, "ok"sv);
+	BOOST_TEST(size == right.size());
+	BOOST_TEST(std::string_view(buf.data(), size) == right);
+}
+BOOST_AUTO_TEST_CASE(chunked)
+{
+	request_generator gen;
+	gen.uri("http://g.c/p/a"sv).make_chunked();
+	std::array<char, 128> buf;
+	auto right = "GET /p/a HTTP/1.1\r\nHost: g.c\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nab\r\n"sv;
+	BOOST_TEST(gen.body_to(std::span(buf).first(2), "ab"sv) == right.size());
+	BOOST_TEST(gen.body_to(buf, "ab"sv) == right.size());
+	BOOST_TEST(std::string_view(buf.data(), right.size()) == right);
+	BOOST_TEST(gen.body_to(std::span(buf).first(2), "test"sv) == 9);
+	BOOST_TEST(gen.body_to(buf, "test"sv) == 9);
+	BOOST_TEST(std::string_view(buf.data(), 9) == "4\r\ntest\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(memory)
+{
+	request_generator gen;
+	gen.response(404, "Not Found").header("Server", "t");
+	std::array<char, 128> buf;
+
+	auto dr = std::pmr::get_default_resource();
+	std::pmr::set_default_resource( std::pmr::null_memory_resource() );
+	std::shared_ptr<void> memory_raii(nullptr, [dr](auto){ std::pmr::set_default_resource( dr ); });
+
+	std::size_t size = gen.body_to(buf, "no"sv);
+	BOOST_TEST(std::string_view(buf.data(), size) ==
+	           "HTTP/1.1 404 Not Found\r\nServer: t\r\nContent-Length: 2\r\n\r\nno"sv);
+}
+BOOST_AUTO_TEST_SUITE_END() // to_span
+BOOST_AUTO_TEST_CASE(header_block)
+{
+	using namespace http_parser;
+	request_generator gen;
+	auto common = gen.make_header_block();
+	common.add("Server", "t").add("Cache-Control", "no-cache");
+	auto cors = gen.make_header_block();
+	cors.add("Access-Control-Allow-Origin", "*");
+	BOOST_TEST(common.data() == "Server: t\r\nCache-Control: no-cache\r\n"sv);
+
+	gen.response(200, "OK").headers_block(common);
+	gen << cors << header("X-Id", "1");
+	BOOST_TEST(gen.body("ok"sv) == "HTTP/1.1 200 OK\r\n"
+	                              "Server: t\r\nCache-Control: no-cache\r\n"
+	                              "Access-Control-Allow-Origin: *\r\n"
+	                              "X-Id: 1\r\n"
+	                              "Content-Length: 2\r\n\r\nok"sv);
+	request_generator other;
+	other.response(404, "Not Found").headers_block(common);
+	BOOST_TEST(other.body(""sv) == "HTTP/1.1 404 Not Found\r\n"
+	                               "Server: t\r\nCache-Control: no-cache\r\n\r\n"sv);
+}
 BOOST_AUTO_TEST_CASE(methods)
 {
 	request_generator gen;
@@ -172,5 +358,182 @@ BOOST_AUTO_TEST_CASE(response)
 	                              "content"
 	           );
 }
+BOOST_AUTO_TEST_CASE(response_table)
+{
+	using namespace http_parser;
+	static_assert(find_status_line(404).view() == "HTTP/1.1 404 Not Found\r\n"sv);
+	static_assert(find_status_line(299).view() == "HTTP/1.1 299 \r\n"sv);
+	BOOST_TEST(find_status_line(511).view() == "HTTP/1.1 511 Network Authentication Required\r\n"sv);
+
+	request_generator gen;
+	gen.response(503).header("test", "value");
+	BOOST_TEST(gen.body("x"sv) == "HTTP/1.1 503 Service Unavailable\r\n"
+	                              "test: value\r\n"
+	                              "Content-Length: 1\r\n\r\n"
+	                              "x"
+	           );
+	BOOST_CHECK_THROW(gen.response(99), std::runtime_error);
+	BOOST_CHECK_THROW(gen.response(600), std::runtime_error);
+
+	using data_generator = basic_generator<pmr_vector_t_factory<std::byte>, std::string_view>;
+	data_generator dgen;
+	auto result = dgen.response(200).body(""sv);
+	BOOST_TEST(std::string_view((const char*)result.data(), result.size()) == "HTTP/1.1 200 OK\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_SUITE(coalescer)
+struct fake_steady {
+	using duration = std::chrono::milliseconds;
+	using time_point = std::chrono::time_point<fake_steady, duration>;
+	static inline std::int64_t value = 0;
+	static time_point now() { return time_point(duration(value)); }
+};
+using coalescer_t = http_parser::generators::chunk_coalescer<request_generator, fake_steady>;
+BOOST_AUTO_TEST_CASE(by_size)
+{
+	request_generator gen;
+	gen.response(200);
+	coalescer_t wr(gen, std::pmr::string{}, 5);
+	BOOST_TEST(gen.chunked() == true);
+	BOOST_TEST(wr.write("ab"sv).has_value() == false);
+	BOOST_TEST(wr.write("c"sv).has_value() == false);
+	BOOST_TEST(wr.buffered() == 3);
+	auto out = wr.write("de"sv);
+	BOOST_TEST_REQUIRE(out.has_value());
+	BOOST_TEST(*out == "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nabcde\r\n"sv);
+	BOOST_TEST(wr.write("f"sv).has_value() == false);
+	out = wr.write("big one"sv);
+	BOOST_TEST_REQUIRE(out.has_value());
+	BOOST_TEST(*out == "1\r\nf\r\n7\r\nbig one\r\n"sv);
+	BOOST_TEST(*wr.write("another"sv) == "7\r\nanother\r\n"sv);
+	BOOST_TEST(wr.write("x"sv).has_value() == false);
+	BOOST_TEST(wr.finish() == "1\r\nx\r\n0\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(by_deadline)
+{
+	request_generator gen;
+	gen.response(200);
+	coalescer_t wr(gen, std::pmr::string{}, 100, std::chrono::milliseconds(10));
+	fake_steady::value = 0;
+	BOOST_TEST(wr.write("ab"sv).has_value() == false);
+	BOOST_TEST(wr.expired(fake_steady::now()) == false);
+	fake_steady::value = 10;
+	BOOST_TEST(wr.expired(fake_steady::now()) == true);
+	auto out = wr.write("c"sv);
+	BOOST_TEST_REQUIRE(out.has_value());
+	BOOST_TEST(*out == "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n"sv);
+	BOOST_TEST(wr.expired(fake_steady::now()) == false);
+	BOOST_TEST(wr.flush().has_value() == false);
+	BOOST_TEST(wr.finish() == "0\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(empty)
+{
+	request_generator gen;
+	gen.response(204);
+	coalescer_t wr(gen, std::pmr::string{}, 100);
+	BOOST_TEST(wr.finish() == "HTTP/1.1 204 No Content\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(started_generator)
+{
+	request_generator gen;
+	gen.response(200).make_chunked();
+	BOOST_TEST(gen.body("ab"sv) == "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nab\r\n"sv);
+	coalescer_t wr(gen, std::pmr::string{}, 100);
+	BOOST_TEST(wr.finish() == "0\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_SUITE_END() // coalescer
+BOOST_AUTO_TEST_CASE(batch)
+{
+	using batch_t = http_parser::generators::response_batch<std::pmr::string>;
+	batch_t batch(std::pmr::string{}, 256);
+	request_generator ok, not_found;
+	ok.response(200);
+	not_found.response(404);
+	batch.add(ok, "a"sv).add(not_found, ""sv).add(ok, "bc"sv);
+	BOOST_TEST(batch.count() == 3);
+	BOOST_TEST(batch.data() ==
+	           "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\na"
+	           "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"
+	           "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nbc"sv);
+
+	const char* buf = batch.data().data();
+	batch.clear();
+	BOOST_TEST(batch.empty());
+	BOOST_TEST(batch.size() == 0);
+	batch.add(not_found, ""sv);
+	BOOST_TEST(batch.data().data() == buf);
+	BOOST_TEST(batch.data() == "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"sv);
+
+	batch.add(http_parser::generators::static_response<200, "ok">);
+	BOOST_TEST(batch.count() == 2);
+	BOOST_TEST(batch.data() == "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"
+	                           "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok"sv);
+
+	request_generator no_content;
+	no_content.response(204);
+	batch.clear();
+	batch.add(no_content, ""sv);
+	BOOST_TEST(batch.data() == "HTTP/1.1 204 No Content\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(static_response)
+{
+	using http_parser::generators::static_response;
+	constexpr auto& not_found = static_response<404, "not found", "Content-Type: text/plain">;
+	static_assert(not_found.view() == "HTTP/1.1 404 Not Found\r\n"
+	                                  "Content-Type: text/plain\r\n"
+	                                  "Content-Length: 9\r\n\r\n"
+	                                  "not found"sv);
+	static_assert(static_response<204>.view() == "HTTP/1.1 204 No Content\r\n\r\n"sv);
+	static_assert(static_response<503>.view() == "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"sv);
+
+	constexpr auto& healthz_data = static_response<200, "OK", "Content-Type: text/plain", "Cache-Control: no-store">;
+	auto healthz = healthz_data.buffer();
+	BOOST_TEST(std::string_view((const char*)healthz.data, healthz.size) ==
+	           "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nCache-Control: no-store\r\n"
+	           "Content-Length: 2\r\n\r\nOK"sv);
+	BOOST_TEST(healthz.data == healthz_data.data());
+}
+BOOST_AUTO_TEST_SUITE(date)
+struct fake_clock {
+	using duration = std::chrono::seconds;
+	using time_point = std::chrono::time_point<fake_clock, duration>;
+	static inline std::int64_t value = 784111777;
+	static time_point now() { return time_point(duration(value)); }
+};
+BOOST_AUTO_TEST_CASE(format)
+{
+	using http_parser::format_imf_fixdate;
+	static_assert(std::string_view(format_imf_fixdate(784111777).data(), 29) == "Sun, 06 Nov 1994 08:49:37 GMT"sv);
+	BOOST_TEST(std::string_view(format_imf_fixdate(0).data(), 29) == "Thu, 01 Jan 1970 00:00:00 GMT"sv);
+	BOOST_TEST(std::string_view(format_imf_fixdate(951782400).data(), 29) == "Tue, 29 Feb 2000 00:00:00 GMT"sv);
+	BOOST_TEST(std::string_view(format_imf_fixdate(4102444799).data(), 29) == "Thu, 31 Dec 2099 23:59:59 GMT"sv);
+}
+BOOST_AUTO_TEST_CASE(header)
+{
+	using provider = http_parser::cached_date<fake_clock>;
+	request_generator gen;
+	gen.response(200).date<provider>();
+	BOOST_TEST(gen.body(""sv) == "HTTP/1.1 200 OK\r\nDate: Sun, 06 Nov 1994 08:49:37 GMT\r\n\r\n"sv);
+	fake_clock::value += 1;
+	BOOST_TEST(provider::now() == "Sun, 06 Nov 1994 08:49:38 GMT"sv);
+
+	gen.date<provider>();
+	BOOST_TEST(gen.body(""sv) == "HTTP/1.1 200 OK\r\nDate: Sun, 06 Nov 1994 08:49:38 GMT\r\n\r\n"sv);
+	gen.reset().response(204);
+	BOOST_TEST(gen.body(""sv) == "HTTP/1.1 204 No Content\r\n\r\n"sv);
+}
+BOOST_AUTO_TEST_CASE(speed, * utf::label("speed") * utf::enable_if<enable_speed_tests>())
+{
+	request_generator gen;
+	gen.response(200).header("Server", "t");
+	std::array<char, 256> buf;
+	std::size_t total = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(std::size_t i=0;i<1'000'000;++i)
+		total += gen.date().body_to(buf, "OK"sv);
+	auto stop = std::chrono::high_resolution_clock::now();
+	BOOST_TEST(total != 0);
+	BOOST_TEST(std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() < 1000);
+}
+BOOST_AUTO_TEST_SUITE_END() // date
 BOOST_AUTO_TEST_SUITE_END() // generator
 BOOST_AUTO_TEST_SUITE_END() // core
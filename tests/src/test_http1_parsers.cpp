@@ -47,6 +47,7 @@ BOOST_AUTO_TEST_CASE(request_message)
 	prs();
 	BOOST_TEST(prs.end_position() == data.size());
 	BOOST_TEST(prs.req_msg().method() == "GET"sv);
+	BOOST_TEST((prs.req_msg().method_code() == http_parser::methods::get));
 	BOOST_TEST(prs.req_msg().url().uri() == "/path"sv);
 }
 BOOST_AUTO_TEST_CASE(response_message)
@@ -42,6 +42,32 @@ BOOST_AUTO_TEST_CASE(method)
 	req_head_message msg(&data);
 	msg.method(0,3);
 	BOOST_TEST(msg.method() == "GET"sv);
+	BOOST_TEST((msg.method_code() == http_parser::methods::get));
+}
+BOOST_AUTO_TEST_CASE(method_code)
+{
+	using http_parser::methods;
+	using http_parser::classify_method;
+	BOOST_TEST((classify_method("GET"sv) == methods::get));
+	BOOST_TEST((classify_method("HEAD"sv) == methods::head));
+	BOOST_TEST((classify_method("POST"sv) == methods::post));
+	BOOST_TEST((classify_method("PUT"sv) == methods::put));
+	BOOST_TEST((classify_method("DELETE"sv) == methods::delete_method));
+	BOOST_TEST((classify_method("CONNECT"sv) == methods::connect));
+	BOOST_TEST((classify_method("TRACE"sv) == methods::trace));
+	BOOST_TEST((classify_method("PATCH"sv) == methods::patch));
+	BOOST_TEST((classify_method("OPTIONS"sv) == methods::options));
+	BOOST_TEST((classify_method("get"sv) == methods::unknown));
+	BOOST_TEST((classify_method("GETS"sv) == methods::unknown));
+	BOOST_TEST((classify_method("DEL"sv) == methods::unknown));
+	BOOST_TEST((classify_method(""sv) == methods::unknown));
+	BOOST_TEST((classify_method("PROPFIND"sv) == methods::unknown));
+
+	std::string data = "DELETE /path HTTP/1.1\r\n"s;
+	req_head_message msg(&data);
+	BOOST_TEST((msg.method_code() == methods::unknown));
+	msg.method(0,6);
+	BOOST_TEST((msg.method_code() == methods::delete_method));
 }
 BOOST_AUTO_TEST_SUITE_END() // req_head
 BOOST_AUTO_TEST_CASE(resp_head)
@@ -2,17 +2,30 @@
 #define BOOST_TEST_MODULE routers
 
 #include <chrono>
+#include <thread>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/data/dataset.hpp>
 #include <boost/test/data/test_case.hpp>
 
 #include <http_parser/utils/factories.hpp>
 #include <http_parser/utils/directory_router.hpp>
+#include <http_parser/utils/static_router.hpp>
+#include <http_parser/utils/router_handle.hpp>
+#include <http_parser/utils/host_router.hpp>
+#include <http_parser/message.hpp>
 
 using namespace std::literals;
 namespace utf = boost::unit_test;
 namespace data = boost::unit_test_framework::data;
 
+constexpr bool enable_speed_tests =
+        #ifdef  ENABLE_SPEED_TESTS
+        true
+        #else
+        false
+        #endif
+        ;
+
 BOOST_AUTO_TEST_SUITE(utils)
 BOOST_AUTO_TEST_SUITE(router)
 BOOST_AUTO_TEST_CASE(directory)
@@ -76,5 +89,300 @@ BOOST_AUTO_TEST_CASE(creation)
 	r2.add("/other", []{}).add("/", []{}).add("/ttt", []{});
 	BOOST_TEST(r2.size() == 4);
 }
+BOOST_AUTO_TEST_CASE(functor_storage)
+{
+	struct counting {
+		std::shared_ptr<int> cnt;
+		void operator()() const { ++*cnt; }
+	};
+	auto cnt = std::make_shared<int>(0);
+	std::string called;
+	{
+		std::pmr::unsynchronized_pool_resource mr;
+		http_parser::directory_router r((std::pmr::memory_resource*)&mr, http_parser::pmr_vector_factory{&mr});
+		r.add("/big"sv, [s = std::string(100, 'x'), &called]{ called = s.substr(0, 3); })
+		 .add("/counting"sv, counting{cnt})
+		 .add("/small"sv, [&called]{ called = "small"; })
+		 ;
+		BOOST_TEST(*cnt.get() == 0);
+		BOOST_TEST(cnt.use_count() == 2);
+		BOOST_CHECK_THROW(r.add("/counting"sv, counting{cnt}), std::runtime_error);
+		BOOST_TEST(cnt.use_count() == 2);
+		BOOST_TEST(r.size() == 3);
+		BOOST_TEST(r("/big"sv));
+		BOOST_TEST(called == "xxx");
+		BOOST_TEST(r("/small"sv));
+		BOOST_TEST(called == "small");
+		BOOST_TEST(r("/counting"sv));
+		BOOST_TEST(*cnt.get() == 1);
+
+		http_parser::directory_router moved(std::move(r));
+		BOOST_TEST(moved("/counting"sv));
+		BOOST_TEST(*cnt.get() == 2);
+		BOOST_TEST(cnt.use_count() == 2);
+	}
+	BOOST_TEST(cnt.use_count() == 1);
+}
+BOOST_AUTO_TEST_CASE(longest_prefix)
+{
+	http_parser::directory_router r;
+	std::string called;
+	r.add("/"sv, [&called](std::string_view tail){ called = "root:"s + std::string(tail); })
+	 .add("/static/"sv, [&called](std::string_view tail){ called = "static:"s + std::string(tail); })
+	 .add("/static/img/"sv, [&called](std::string_view tail){ called = "img:"s + std::string(tail); })
+	 .add("/static/img/logo.png"sv, [&called]{ called = "logo"; })
+	 ;
+	BOOST_CHECK_THROW(r.add("/static/img/logo.png"sv, [&called]{ called = "duplicate"; }), std::runtime_error);
+	BOOST_TEST(r.size() == 4);
+
+	BOOST_TEST(r("/index.html"sv));
+	BOOST_TEST(called == "root:index.html");
+	BOOST_TEST(r("/static/a.css"sv));
+	BOOST_TEST(called == "static:a.css");
+	BOOST_TEST(r("/static/img/b.png"sv));
+	BOOST_TEST(called == "img:b.png");
+	BOOST_TEST(r("/static/img/logo.png"sv));
+	BOOST_TEST(called == "logo");
+	BOOST_TEST(r("/static/img/logo.png2"sv));
+	BOOST_TEST(called == "img:logo.png2");
+	BOOST_TEST(r("/static/im"sv));
+	BOOST_TEST(called == "static:im");
+	BOOST_TEST(r("nothing"sv) == false);
+}
+BOOST_AUTO_TEST_CASE(captures)
+{
+	using captures_t = http_parser::directory_router<>::captures_t;
+	http_parser::directory_router r;
+	std::string called;
+	std::vector<std::string> args;
+	auto save = [&args](const captures_t& caps) {
+		args.clear();
+		for(auto& c:caps) args.emplace_back(c);
+	};
+	r.add("/users/{id}/orders/{order}"sv, [&](const captures_t& caps){ called = "order"; save(caps); })
+	 .add("/users/me"sv, [&]{ called = "me"; args.clear(); })
+	 .add("/users/{id}"sv, [&](std::string_view path, const captures_t& caps){ called = std::string(path); save(caps); })
+	 .add("/files/{bucket}/"sv, [&](std::string_view tail, const captures_t& caps){ called = "file:" + std::string(tail); save(caps); })
+	 ;
+
+	BOOST_TEST(r("/users/42/orders/7"sv));
+	BOOST_TEST(called == "order");
+	BOOST_TEST(args == (std::vector<std::string>{"42", "7"}));
+	BOOST_TEST(r("/users/me"sv));
+	BOOST_TEST(called == "me");
+	BOOST_TEST(r("/users/mee"sv));
+	BOOST_TEST(called == "/users/mee");
+	BOOST_TEST(args == (std::vector<std::string>{"mee"}));
+	BOOST_TEST(r("/users/me/orders/1"sv));
+	BOOST_TEST(called == "order");
+	BOOST_TEST(args == (std::vector<std::string>{"me", "1"}));
+	BOOST_TEST(r("/files/b1/a/b.txt"sv));
+	BOOST_TEST(called == "file:a/b.txt");
+	BOOST_TEST(args == (std::vector<std::string>{"b1"}));
+
+	BOOST_TEST(r("/users/"sv) == false);
+	BOOST_TEST(r("/users/42/orders"sv) == false);
+	BOOST_TEST(r("/users/42/orders/"sv) == false);
+
+	BOOST_CHECK_THROW(r.add("/bad{id}"sv, []{}), std::runtime_error);
+	BOOST_CHECK_THROW(r.add("/bad/{id}x"sv, []{}), std::runtime_error);
+}
+BOOST_AUTO_TEST_CASE(methods)
+{
+	using http_parser::methods;
+	using http_parser::route_status;
+	http_parser::directory_router r;
+	std::string called;
+	r.add(methods::get, "/items"sv, [&called]{ called = "get"; })
+	 .add(methods::post, "/items"sv, [&called]{ called = "post"; })
+	 .add("/any"sv, [&called]{ called = "any"; })
+	 .add(methods::delete_method, "/any"sv, [&called]{ called = "delete"; })
+	 .add(methods::get, "/static/"sv, [&called](std::string_view tail){ called = "static " + std::string(tail); })
+	 ;
+
+	BOOST_TEST((r(methods::get, "/items"sv) == route_status::found));
+	BOOST_TEST(called == "get");
+	BOOST_TEST((r(methods::post, "/items"sv) == route_status::found));
+	BOOST_TEST(called == "post");
+	BOOST_TEST((r(methods::put, "/items"sv) == route_status::method_not_allowed));
+	BOOST_TEST((r(methods::get, "/nothing"sv) == route_status::not_found));
+	BOOST_TEST(r("/items"sv) == false);
+
+	BOOST_TEST((r(methods::put, "/any"sv) == route_status::found));
+	BOOST_TEST(called == "any");
+	BOOST_TEST((r(methods::delete_method, "/any"sv) == route_status::found));
+	BOOST_TEST(called == "delete");
+	BOOST_TEST(r("/any"sv) == true);
+	BOOST_TEST(called == "any");
+
+	BOOST_TEST((r(methods::get, "/static/a.css"sv) == route_status::found));
+	BOOST_TEST(called == "static a.css");
+	BOOST_TEST((r(methods::head, "/static/a.css"sv) == route_status::method_not_allowed));
+
+	std::string data = "POST /items?a=1 HTTP/1.1\r\n"s;
+	http_parser::req_head_message head(&data);
+	head.method(0, 4).url(5, 9);
+	BOOST_TEST((head.method_code() == methods::post));
+	BOOST_TEST((r(head) == route_status::found));
+	BOOST_TEST(called == "post");
+}
+BOOST_AUTO_TEST_CASE(static_router)
+{
+	using routes = http_parser::static_routes<"/", "/healthz", "/static/", "/static/img/", "/api/v1/users", "/api/v1/orders">;
+	static_assert(routes::find("/healthz") == 1);
+	static_assert(routes::find("/api/v1/users") == 4);
+	static_assert(routes::find("/api/v1/orders") == 5);
+	static_assert(routes::find("/static/a.css") == 2);
+	static_assert(routes::find("/static/img/a.png") == 3);
+	static_assert(routes::find("/other") == 0);
+	static_assert(http_parser::static_routes<"/a">::find("/b") == http_parser::static_routes<"/a">::npos);
+	static_assert(http_parser::static_routes<"/a/">::find("/a") == http_parser::static_routes<"/a/">::npos);
+
+	std::string called;
+	auto r = http_parser::make_static_router<"/healthz", "/static/", "/api/v1/users">(
+	            [&called]{ called = "health"; },
+	            [&called](std::string_view tail){ called = "static " + std::string(tail); },
+	            [&called](std::string_view path){ called = std::string(path); }
+	            );
+	BOOST_TEST(r("/healthz"sv));
+	BOOST_TEST(called == "health");
+	BOOST_TEST(r("/static/a/b.css"sv));
+	BOOST_TEST(called == "static a/b.css");
+	BOOST_TEST(r("/api/v1/users"sv));
+	BOOST_TEST(called == "/api/v1/users");
+	BOOST_TEST(r("/api/v1/user"sv) == false);
+	BOOST_TEST(r("/healthz/"sv) == false);
+	BOOST_TEST(r(""sv) == false);
+}
+BOOST_AUTO_TEST_CASE(router_handle)
+{
+	using router_t = http_parser::directory_router<>;
+	auto make = [](int version, std::atomic<int>& seen) {
+		router_t r;
+		r.add("/v", [version,&seen]{ seen.store(version); });
+		return r;
+	};
+
+	std::atomic<int> seen{0};
+	http_parser::router_handle<router_t> handle(make(1, seen));
+	BOOST_TEST(handle("/v"sv));
+	BOOST_TEST(seen.load() == 1);
+	BOOST_TEST(handle.read([](const router_t& r){ return r("/none"sv); }) == false);
+
+	std::atomic<bool> stop{false};
+	std::atomic<std::size_t> calls{0};
+	std::atomic<int> started{0};
+	std::vector<std::thread> workers;
+	for(int i=0;i<4;++i) workers.emplace_back([&]{
+		if(handle("/v"sv)) ++calls;
+		++started;
+		while(!stop.load()) if(handle("/v"sv)) ++calls;
+	});
+	while(started.load() != 4) std::this_thread::yield();
+	for(int v=2;v<=100;++v) handle.publish(make(v, seen));
+	stop = true;
+	for(auto& w:workers) w.join();
+
+	BOOST_TEST(handle("/v"sv));
+	BOOST_TEST(seen.load() == 100);
+	BOOST_TEST(0 < calls.load());
+}
+BOOST_AUTO_TEST_CASE(host_router)
+{
+	using router_t = http_parser::directory_router<>;
+	http_parser::host_router<router_t> hosts;
+	std::string called;
+	auto make = [&called](std::string name) {
+		router_t r;
+		r.add("/", [&called,name]{ called = name; });
+		return r;
+	};
+	hosts.add("example.com"sv, make("exact"));
+	hosts.add("*.example.com"sv, make("wildcard"));
+	hosts.add("*.api.Example.com"sv, make("api"));
+	hosts.add("other.org:8080"sv, make("other"));
+	BOOST_TEST(hosts.size() == 4);
+	BOOST_CHECK_THROW(hosts.add("EXAMPLE.com"sv, make("dup")), std::runtime_error);
+	BOOST_CHECK_THROW(hosts.add("*.example.com"sv, make("dup")), std::runtime_error);
+
+	auto call = [&](std::string_view host) {
+		called.clear();
+		auto* r = hosts.find(host);
+		if(r) (*r)("/"sv);
+		return called;
+	};
+	BOOST_TEST(call("example.com") == "exact");
+	BOOST_TEST(call("Example.COM:443") == "exact");
+	BOOST_TEST(call("example.com.") == "exact");
+	BOOST_TEST(call("www.example.com") == "wildcard");
+	BOOST_TEST(call("a.b.example.com") == "wildcard");
+	BOOST_TEST(call("v1.api.example.com") == "api");
+	BOOST_TEST(call("api.example.com") == "wildcard");
+	BOOST_TEST(call("other.org") == "other");
+	BOOST_TEST(call("xexample.com") == "");
+	BOOST_TEST(call(".example.com") == "");
+	BOOST_TEST(call("") == "");
+	BOOST_TEST(hosts.find("[::1]:80"sv) == nullptr);
+
+	for(int i=0;i<100;++i) hosts.add("host" + std::to_string(i) + ".net", make(std::to_string(i)));
+	BOOST_TEST(call("host42.net") == "42");
+	BOOST_TEST(call("www.example.com") == "wildcard");
+
+	std::string data = "Host: www.example.com\r\n"s;
+	http_parser::header_message<std::string, http_parser::pmr_vector_factory> msg(&data, http_parser::pmr_vector_factory{});
+	msg.add_header_name(0, 4);
+	msg.last_header_value(6, 15);
+	const auto& chosts = hosts;
+	BOOST_TEST(chosts.find(msg) == hosts.find("www.example.com"sv));
+}
+BOOST_AUTO_TEST_CASE(radix_tree)
+{
+	http_parser::radix_tree tree;
+	BOOST_TEST(tree.add("/abc"sv, 0, false));
+	BOOST_TEST(tree.add("/abd/"sv, 1, true));
+	BOOST_TEST(tree.add("/a"sv, 2, false));
+	BOOST_TEST(tree.add("/abc"sv, 3, true));
+	BOOST_TEST(tree.add("/abc"sv, 4, false) == false);
+	BOOST_TEST(tree.add(""sv, 5, false));
+
+	BOOST_TEST(tree.find("/abc"sv).value == 0);
+	BOOST_TEST(tree.find("/abc"sv).exact == true);
+	BOOST_TEST(tree.find("/abcd"sv).value == 3);
+	BOOST_TEST(tree.find("/abcd"sv).matched == 4);
+	BOOST_TEST(tree.find("/abd/x"sv).value == 1);
+	BOOST_TEST(tree.find("/abd"sv).value == tree.npos);
+	BOOST_TEST(tree.find("/a"sv).value == 2);
+	BOOST_TEST(tree.find("/ab"sv).value == tree.npos);
+	BOOST_TEST(tree.find(""sv).value == 5);
+	BOOST_TEST(!tree.find("/b"sv));
+}
+BOOST_TEST_DECORATOR(* utf::label("speed") * utf::enable_if<enable_speed_tests>())
+BOOST_DATA_TEST_CASE(speed, data::make({10, 1000, 10000}), count)
+{
+	std::vector<std::string> patterns;
+	patterns.reserve(count * 2);
+	for(int i=0;i<count;++i) {
+		patterns.emplace_back("/api/v1/resource" + std::to_string(i * 7919 % 100000));
+		patterns.emplace_back("/static/" + std::to_string(i) + "/");
+	}
+	std::size_t called = 0;
+	http_parser::directory_router r;
+	for(auto& p:patterns) r.add(std::string_view(p), [&called]{ ++called; });
+
+	std::vector<std::string> paths;
+	for(int i=0;i<count;i+=std::max(1, count/10)) {
+		paths.emplace_back(patterns[i*2]);
+		paths.emplace_back(patterns[i*2+1] + "file.css");
+	}
+
+	constexpr std::size_t lookups = 1'000'000;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(std::size_t i=0;i<lookups;++i) r(std::string_view(paths[i % paths.size()]));
+	auto stop = std::chrono::high_resolution_clock::now();
+	auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+	BOOST_TEST_MESSAGE("routes " << patterns.size() << ": " << dur << "ms for " << lookups << " lookups");
+	BOOST_TEST(called == lookups);
+	BOOST_TEST(dur < 1000);
+}
 BOOST_AUTO_TEST_SUITE_END() // router
 BOOST_AUTO_TEST_SUITE_END() // utils
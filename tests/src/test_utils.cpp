@@ -10,6 +10,11 @@
 #include <http_parser/utils/find.hpp>
 #include <http_parser/utils/inner_static_vector.hpp>
 #include <http_parser/utils/md5.hpp>
+#include <http_parser/utils/session_table.hpp>
+#include <http_parser/utils/timer_wheel.hpp>
+#include <http_parser/utils/sha1.hpp>
+#include <http_parser/utils/base64.hpp>
+#include <http_parser/utils/utf8.hpp>
 
 using namespace std::literals;
 namespace utf = boost::unit_test;
@@ -225,6 +230,10 @@ BOOST_AUTO_TEST_CASE(emplace_back)
 	BOOST_TEST(vec.size() == 1);
 	BOOST_TEST(vec[0] == 0);
 	BOOST_CHECK_THROW(vec.emplace_back(1), std::out_of_range);
+	vec.clear();
+	BOOST_TEST(vec.empty() == true);
+	vec.emplace_back(2);
+	BOOST_TEST(vec[0] == 2);
 }
 BOOST_AUTO_TEST_CASE(ctor_back)
 {
@@ -256,6 +265,184 @@ BOOST_AUTO_TEST_CASE(begin_end)
 }
 BOOST_AUTO_TEST_SUITE_END() // inner_vec
 
+BOOST_AUTO_TEST_SUITE(sessions)
+BOOST_AUTO_TEST_CASE(table)
+{
+	http_parser::session_table<std::uintptr_t, std::string> tbl;
+	BOOST_TEST(tbl.find(1) == nullptr);
+	for(std::uintptr_t i=1;i<=1000;++i) {
+		auto [val, created] = tbl.try_emplace(i * 64);
+		BOOST_TEST(created);
+		*val = std::to_string(i);
+	}
+	BOOST_TEST(tbl.size() == 1000);
+	BOOST_TEST(tbl.try_emplace(64).second == false);
+	BOOST_TEST_REQUIRE(tbl.find(64 * 500) != nullptr);
+	BOOST_TEST(*tbl.find(64 * 500) == "500");
+
+	for(std::uintptr_t i=1;i<=1000;i+=2) BOOST_TEST(tbl.erase(i * 64));
+	BOOST_TEST(tbl.erase(64) == false);
+	BOOST_TEST(tbl.size() == 500);
+	BOOST_TEST(tbl.find(64 * 501) == nullptr);
+	BOOST_TEST(*tbl.find(64 * 502) == "502");
+
+	std::size_t count = 0;
+	for(auto& s:tbl) {
+		BOOST_TEST(s.first % 128 == 0);
+		BOOST_TEST(s.second == std::to_string(s.first / 64));
+		++count;
+	}
+	BOOST_TEST(count == 500);
+
+	// tombstones are reused and dropped on rehash
+	for(int round=0;round<100;++round) {
+		for(std::uintptr_t i=0;i<100;++i) tbl.try_emplace(100000 + round * 1000 + i);
+		for(std::uintptr_t i=0;i<100;++i) tbl.erase(100000 + round * 1000 + i);
+	}
+	BOOST_TEST(tbl.size() == 500);
+	BOOST_TEST(*tbl.find(64 * 1000) == "1000");
+}
+BOOST_AUTO_TEST_CASE(wheel)
+{
+	http_parser::timer_wheel<int> wheel;
+	std::vector<std::pair<int, std::uint64_t>> fired;
+	auto on_fire = [&](int id){ fired.emplace_back(id, wheel.now()); };
+	wheel.schedule(1, 5);
+	wheel.schedule(2, 64);
+	wheel.schedule(3, 100);
+	wheel.schedule(4, 5000);
+	wheel.schedule(5, 300000);
+	BOOST_TEST(wheel.size() == 5);
+
+	wheel.advance(4, on_fire);
+	BOOST_TEST(fired.empty());
+	wheel.advance(5, on_fire);
+	BOOST_TEST_REQUIRE(fired.size() == 1);
+	BOOST_TEST(fired[0].second == 5);
+	wheel.advance(200, on_fire);
+	BOOST_TEST_REQUIRE(fired.size() == 3);
+	BOOST_TEST(fired[1].first == 2);
+	BOOST_TEST(fired[1].second == 64);
+	BOOST_TEST(fired[2].first == 3);
+	BOOST_TEST(fired[2].second == 100);
+	wheel.advance(400000, on_fire);
+	BOOST_TEST_REQUIRE(fired.size() == 5);
+	BOOST_TEST(fired[3].second == 5000);
+	BOOST_TEST(fired[4].second == 300000);
+	BOOST_TEST(wheel.size() == 0);
+
+	wheel.advance(500000, on_fire);
+	BOOST_TEST(wheel.now() == 500000);
+	wheel.schedule(6, 1);
+	wheel.advance(500001, [&](int id){ wheel.schedule(id + 1, wheel.now() + 10); on_fire(id); });
+	BOOST_TEST(fired.back().first == 6);
+	wheel.advance(500011, on_fire);
+	BOOST_TEST(fired.back().first == 7);
+	BOOST_TEST(fired.back().second == 500011);
+}
+BOOST_AUTO_TEST_SUITE_END() // sessions
+
+BOOST_AUTO_TEST_SUITE(hashes)
+std::string hex(const http_parser::sha1::digest_t& d)
+{
+	std::string ret;
+	for(auto b:d) {
+		ret.push_back("0123456789abcdef"[b >> 4]);
+		ret.push_back("0123456789abcdef"[b & 0xF]);
+	}
+	return ret;
+}
+BOOST_AUTO_TEST_CASE(sha1)
+{
+	using http_parser::sha1;
+	BOOST_TEST(hex(sha1{}.finish()) == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	BOOST_TEST(hex(sha1{}.update("abc"sv).finish()) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+	BOOST_TEST(hex(sha1{}.update("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"sv).finish())
+	           == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+	sha1 million;
+	std::string part(1000, 'a');
+	for(int i=0;i<1000;++i) million.update(std::string_view(part));
+	BOOST_TEST(hex(million.finish()) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	static_assert(sha1{}.update("abc"sv).finish()[0] == 0xa9);
+}
+BOOST_AUTO_TEST_CASE(base64)
+{
+	auto enc = [](std::string_view src) {
+		std::string out(http_parser::base64_size(src.size()), ' ');
+		auto size = http_parser::base64_encode(std::span((const std::uint8_t*)src.data(), src.size()), out.data());
+		BOOST_TEST(size == out.size());
+		return out;
+	};
+	BOOST_TEST(enc("") == "");
+	BOOST_TEST(enc("f") == "Zg==");
+	BOOST_TEST(enc("fo") == "Zm8=");
+	BOOST_TEST(enc("foo") == "Zm9v");
+	BOOST_TEST(enc("foobar") == "Zm9vYmFy");
+
+	BOOST_TEST(http_parser::base64_decoded_size("Zm9vYmFy") == 6);
+	BOOST_TEST(http_parser::base64_decoded_size("Zm8=") == 2);
+	BOOST_TEST(http_parser::base64_decoded_size("Zg==") == 1);
+	BOOST_TEST(http_parser::base64_decoded_size("dGhlIHNhbXBsZSBub25jZQ==") == 16);
+	BOOST_TEST(http_parser::base64_decoded_size("Zg=") == std::size_t(-1));
+	BOOST_TEST(http_parser::base64_decoded_size("Z=g=") == std::size_t(-1));
+	BOOST_TEST(http_parser::base64_decoded_size("Zm9v*mFy") == std::size_t(-1));
+}
+BOOST_AUTO_TEST_SUITE_END() // hashes
+
+BOOST_AUTO_TEST_SUITE(utf8)
+BOOST_AUTO_TEST_CASE(validation)
+{
+	using http_parser::is_valid_utf8;
+	BOOST_TEST(is_valid_utf8(""));
+	BOOST_TEST(is_valid_utf8("plain ascii text which is longer than a word"));
+	BOOST_TEST(is_valid_utf8("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82"));
+	BOOST_TEST(is_valid_utf8("\xe2\x82\xac \xef\xbf\xbf \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf"));
+	BOOST_TEST(!is_valid_utf8("\xc0\x80"));         // overlong
+	BOOST_TEST(!is_valid_utf8("\xe0\x80\xaf"));     // overlong
+	BOOST_TEST(!is_valid_utf8("\xed\xa0\x80"));     // surrogate
+	BOOST_TEST(!is_valid_utf8("\xf4\x90\x80\x80")); // above U+10FFFF
+	BOOST_TEST(!is_valid_utf8("\xf5\x80\x80\x80"));
+	BOOST_TEST(!is_valid_utf8("abc\x80"));
+	BOOST_TEST(!is_valid_utf8("\xe2\x82"));         // truncated
+	BOOST_TEST(!is_valid_utf8("0123456789abcdef\xe2\x28\xa1"));
+}
+BOOST_AUTO_TEST_CASE(incremental)
+{
+	const std::string text = "ascii prefix, \xd0\xbf\xd1\x80\xd0\xb8 \xe2\x82\xac\xf0\x9f\x98\x80 and ascii suffix";
+	for(std::size_t split=0;split<=text.size();++split) {
+		http_parser::utf8_validator v;
+		BOOST_TEST(v.update(std::string_view(text).substr(0, split)));
+		BOOST_TEST(v.update(std::string_view(text).substr(split)));
+		BOOST_TEST(v.complete());
+	}
+	http_parser::utf8_validator v;
+	BOOST_TEST(v.update("\xf0\x9f"sv));
+	BOOST_TEST(v.valid());
+	BOOST_TEST(!v.complete());
+	BOOST_TEST(!v.update("\x41"sv));
+	v.reset();
+	BOOST_TEST(v.complete());
+}
+BOOST_AUTO_TEST_CASE(ascii)
+{
+	BOOST_TEST(http_parser::is_ascii("Content-Length"sv));
+	BOOST_TEST(http_parser::is_ascii(""sv));
+	BOOST_TEST(!http_parser::is_ascii("Content-Length\xff"sv));
+	BOOST_TEST(!http_parser::is_ascii("0123456789abcdef0123456789abcdef0123456789\x80"sv));
+}
+BOOST_AUTO_TEST_CASE(speed, * utf::label("speed") * utf::enable_if<enable_speed_tests>())
+{
+	std::string data(16 * 1024 * 1024, 'a');
+	for(std::size_t i=0;i<data.size();i+=1024) data.replace(i, 3, "\xe2\x82\xac");
+	auto start = std::chrono::high_resolution_clock::now();
+	bool ok = true;
+	for(int i=0;i<8;++i) ok = ok && http_parser::is_valid_utf8(data);
+	auto dur = std::chrono::high_resolution_clock::now() - start;
+	BOOST_TEST(ok);
+	BOOST_TEST(std::chrono::duration_cast<std::chrono::milliseconds>(dur).count() < 1000);
+}
+BOOST_AUTO_TEST_SUITE_END() // utf8
+
 BOOST_AUTO_TEST_SUITE(md5_tests)
 using http_parser::md5;
 BOOST_AUTO_TEST_CASE(short_string, * utf::label("broken") * utf::enable_if<enable_broken_tests>())
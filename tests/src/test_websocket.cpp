@@ -0,0 +1,532 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE websocket
+
+#include <chrono>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/data/dataset.hpp>
+#include <boost/test/data/test_case.hpp>
+
+#include <http_parser.hpp>
+#include <http_parser/acceptors/ws.hpp>
+#include <http_parser/websocket/frame_parser.hpp>
+#include <http_parser/websocket/frame_writer.hpp>
+#include <http_parser/http1_ws_upgrade.hpp>
+#include <sys/uio.h>
+
+using namespace std::literals;
+namespace utf = boost::unit_test;
+namespace ws = http_parser::websocket;
+
+constexpr bool enable_speed_tests =
+        #ifdef  ENABLE_SPEED_TESTS
+        true
+        #else
+        false
+        #endif
+        ;
+
+namespace {
+
+std::string masked_frame(std::uint8_t b0, std::string_view payload, ws::masking_key key = {0x37, 0xfa, 0x21, 0x3d})
+{
+	std::string ret;
+	ret.push_back((char)b0);
+	if(payload.size() < 126) ret.push_back((char)(0x80 | payload.size()));
+	else if(payload.size() <= 0xFFFF) {
+		ret.push_back((char)(0x80 | 126));
+		ret.push_back((char)(payload.size() >> 8));
+		ret.push_back((char)(payload.size() & 0xFF));
+	} else {
+		ret.push_back((char)(0x80 | 127));
+		for(int i=7;0<=i;--i) ret.push_back((char)((std::uint64_t(payload.size()) >> (8*i)) & 0xFF));
+	}
+	for(auto k:key) ret.push_back((char)k);
+	for(std::size_t i=0;i<payload.size();++i) ret.push_back((char)(payload[i] ^ key[i & 3]));
+	return ret;
+}
+
+struct collected {
+	struct frame { ws::opcode op, message_op; bool fin; std::string payload; };
+	std::vector<frame> frames;
+	std::string piece;
+
+	auto handler()
+	{
+		return [this](const ws::frame_header& fh, std::span<char> payload, bool end) {
+			piece.append(payload.data(), payload.size());
+			if(!end) return;
+			frames.push_back(frame{fh.op, fh.message_op, fh.fin, piece});
+			piece.clear();
+		};
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(websocket)
+BOOST_AUTO_TEST_SUITE(frames)
+BOOST_AUTO_TEST_CASE(rfc_example)
+{
+	std::string data = "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58"s;
+	ws::frame_parser prs;
+	collected c;
+	BOOST_TEST(prs(std::span(data), c.handler()) == data.size());
+	BOOST_TEST_REQUIRE(c.frames.size() == 1);
+	BOOST_TEST(c.frames[0].payload == "Hello");
+	BOOST_TEST(c.frames[0].fin);
+	BOOST_TEST((c.frames[0].op == ws::opcode::text));
+	BOOST_TEST(data.substr(6) == "Hello");
+}
+BOOST_AUTO_TEST_CASE(fragments_and_control)
+{
+	std::string data = masked_frame(0x01, "Hel") + masked_frame(0x89, "ping") + masked_frame(0x80, "lo")
+	        + masked_frame(0x82, std::string(300, 'b')) + masked_frame(0x82, std::string(70000, 'c'))
+	        + masked_frame(0x88, "\x03\xe8"s);
+	ws::frame_parser prs;
+	collected c;
+	BOOST_TEST(prs(std::span(data), c.handler()) == data.size());
+	BOOST_TEST_REQUIRE(c.frames.size() == 6);
+	BOOST_TEST((c.frames[0].message_op == ws::opcode::text));
+	BOOST_TEST(c.frames[0].fin == false);
+	BOOST_TEST((c.frames[1].op == ws::opcode::ping));
+	BOOST_TEST(c.frames[1].payload == "ping");
+	BOOST_TEST((c.frames[2].op == ws::opcode::continuation));
+	BOOST_TEST((c.frames[2].message_op == ws::opcode::text));
+	BOOST_TEST(c.frames[0].payload + c.frames[2].payload == "Hello");
+	BOOST_TEST(c.frames[3].payload == std::string(300, 'b'));
+	BOOST_TEST(c.frames[4].payload == std::string(70000, 'c'));
+	BOOST_TEST((c.frames[5].op == ws::opcode::close));
+	BOOST_TEST(prs.in_fragmented_message() == false);
+}
+BOOST_AUTO_TEST_CASE(streaming)
+{
+	std::string data = masked_frame(0x01, "Hel") + masked_frame(0x8A, "") + masked_frame(0x80, std::string(1000, 'x'));
+	ws::frame_parser prs;
+	collected c;
+	std::size_t pieces = 0;
+	auto hndl = c.handler();
+	for(std::size_t i=0;i<data.size();++i)
+		BOOST_TEST(prs(std::span(data).subspan(i, 1), [&](auto& fh, auto p, bool e){ ++pieces; hndl(fh, p, e); }) == 1);
+	BOOST_TEST_REQUIRE(c.frames.size() == 3);
+	BOOST_TEST(c.frames[0].payload == "Hel");
+	BOOST_TEST((c.frames[1].op == ws::opcode::pong));
+	BOOST_TEST(c.frames[1].payload == "");
+	BOOST_TEST(c.frames[2].payload == std::string(1000, 'x'));
+	BOOST_TEST(pieces == 1004);
+}
+BOOST_AUTO_TEST_CASE(errors)
+{
+	auto check = [](std::string data, ws::frame_error err, std::uint16_t code = ws::close_codes::protocol_error) {
+		ws::frame_parser prs(true, 1024);
+		collected c;
+		prs(std::span(data), c.handler());
+		BOOST_TEST(prs.failed());
+		BOOST_TEST((prs.error() == err));
+		BOOST_TEST(prs.close_code() == code);
+	};
+	check(masked_frame(0xC1, "a"), ws::frame_error::reserved_bits);
+	check(masked_frame(0x83, "a"), ws::frame_error::unknown_opcode);
+	check(masked_frame(0x09, "a"), ws::frame_error::control_fragmented);
+	check(masked_frame(0x89, std::string(126, 'a')), ws::frame_error::control_too_big);
+	check(masked_frame(0x80, "a"), ws::frame_error::unexpected_continuation);
+	check(masked_frame(0x01, "a") + masked_frame(0x81, "b"), ws::frame_error::expected_continuation);
+	check("\x81\x01\x61"s, ws::frame_error::not_masked);
+	check(masked_frame(0x82, std::string(1025, 'a')), ws::frame_error::too_big, ws::close_codes::message_too_big);
+
+	std::string unmasked = "\x81\x01\x61"s;
+	ws::frame_parser client(false);
+	collected c;
+	client(std::span(unmasked), c.handler());
+	BOOST_TEST_REQUIRE(c.frames.size() == 1);
+	BOOST_TEST(c.frames[0].payload == "a");
+}
+BOOST_AUTO_TEST_CASE(utf8)
+{
+	auto run = [](std::string data, bool validate) {
+		ws::frame_parser prs(true, std::numeric_limits<std::uint64_t>::max(), validate);
+		collected c;
+		prs(std::span(data), c.handler());
+		return prs;
+	};
+	// a code point split between fragments with a ping between them
+	auto split = masked_frame(0x01, "ok \xe2\x82"s) + masked_frame(0x89, "") + masked_frame(0x80, "\xac"s);
+	BOOST_TEST(!run(split, true).failed());
+	auto bad = run(masked_frame(0x81, "bad \xc0\x80"s), true);
+	BOOST_TEST(bad.failed());
+	BOOST_TEST((bad.error() == ws::frame_error::invalid_utf8));
+	BOOST_TEST(bad.close_code() == ws::close_codes::invalid_payload);
+	BOOST_TEST(!run(masked_frame(0x81, "bad \xc0\x80"s), false).failed());
+	BOOST_TEST(run(masked_frame(0x81, "truncated \xe2\x82"s), true).failed());
+	BOOST_TEST(!run(masked_frame(0x82, "\xff\xfe"s), true).failed());
+	BOOST_TEST(!run(masked_frame(0x88, "\x03\xe8\xd0\xbf"s), true).failed());
+	BOOST_TEST(run(masked_frame(0x88, "\x03\xe8\xff"s), true).failed());
+	BOOST_TEST(run(masked_frame(0x88, "\x03"s), true).failed());
+}
+BOOST_AUTO_TEST_CASE(unmask)
+{
+	ws::masking_key key{0x01, 0x82, 0x43, 0xC4};
+	for(std::size_t offset=0;offset<4;++offset) for(std::size_t size=0;size<80;++size) {
+		std::vector<unsigned char> data(size), expected(size);
+		for(std::size_t i=0;i<size;++i) {
+			data[i] = (unsigned char)(i * 7);
+			expected[i] = data[i] ^ key[(offset + i) & 3];
+		}
+		ws::unmask(data.data(), data.size(), key, offset);
+		BOOST_TEST(data == expected);
+	}
+}
+BOOST_AUTO_TEST_CASE(unmask_speed, * utf::label("speed") * utf::enable_if<enable_speed_tests>())
+{
+	std::vector<unsigned char> data(16 * 1024 * 1024, 0x5A);
+	auto start = std::chrono::high_resolution_clock::now();
+	for(int i=0;i<16;++i) ws::unmask(data.data(), data.size(), {1, 2, 3, 4}, i);
+	auto dur = std::chrono::high_resolution_clock::now() - start;
+	BOOST_TEST(std::chrono::duration_cast<std::chrono::milliseconds>(dur).count() < 1000);
+}
+BOOST_AUTO_TEST_CASE(headroom)
+{
+	for(std::size_t size : {0, 5, 125, 126, 300, 65535, 65536}) {
+		std::string buf(ws::max_frame_header_size, '-');
+		buf += std::string(size, 'p');
+		auto frame = ws::frame_in_headroom(std::span(buf), ws::max_frame_header_size, ws::opcode::binary);
+		BOOST_TEST(frame.size() == ws::frame_header_size(size) + size);
+		BOOST_TEST((void*)(frame.data() + frame.size()) == (void*)(buf.data() + buf.size()));
+
+		ws::frame_parser prs(false);
+		collected c;
+		BOOST_TEST(prs(frame, c.handler()) == frame.size());
+		BOOST_TEST_REQUIRE(c.frames.size() == 1);
+		BOOST_TEST(c.frames[0].payload == std::string(size, 'p'));
+		BOOST_TEST((c.frames[0].op == ws::opcode::binary));
+	}
+
+	std::string small = "12Hello";
+	BOOST_CHECK_THROW(ws::frame_in_headroom(std::span(small), 1, ws::opcode::text), std::out_of_range);
+	BOOST_CHECK_THROW(ws::frame_in_headroom(std::span(small), small.size() + 1, ws::opcode::text), std::out_of_range);
+	ws::masking_key key{1, 2, 3, 4};
+	auto frame = ws::frame_in_headroom(std::span(small), 2, ws::opcode::text);
+	BOOST_TEST(std::string_view(frame.data(), frame.size()) == "\x81\x05Hello"sv);
+
+	std::string masked(6, ' ');
+	masked += "Hello";
+	auto mframe = ws::frame_in_headroom(std::span(masked), 6, ws::opcode::text, true, &key);
+	ws::frame_parser prs;
+	collected c;
+	prs(mframe, c.handler());
+	BOOST_TEST_REQUIRE(c.frames.size() == 1);
+	BOOST_TEST(c.frames[0].payload == "Hello");
+}
+BOOST_AUTO_TEST_CASE(writer)
+{
+	std::string msg = "fragmented message";
+	ws::frame_writer<char> w(ws::opcode::text, std::span<const char>(msg), 5);
+	std::string wire;
+	std::size_t frames = 0;
+	while(auto f = w.next()) {
+		iovec vecs[2];
+		auto cnt = f->fill(std::span(vecs));
+		BOOST_TEST(cnt == 2);
+		BOOST_TEST(vecs[1].iov_base == (void*)(msg.data() + 5 * frames));
+		for(std::size_t i=0;i<cnt;++i) wire.append((const char*)vecs[i].iov_base, vecs[i].iov_len);
+		++frames;
+	}
+	BOOST_TEST(w.finished());
+	BOOST_TEST(frames == 4);
+
+	ws::frame_parser prs(false);
+	collected c;
+	prs(std::span(wire), c.handler());
+	BOOST_TEST_REQUIRE(c.frames.size() == 4);
+	BOOST_TEST((c.frames[0].op == ws::opcode::text));
+	BOOST_TEST((c.frames[3].op == ws::opcode::continuation));
+	BOOST_TEST(c.frames[3].fin);
+	std::string joined;
+	for(auto& f:c.frames) joined += f.payload;
+	BOOST_TEST(joined == msg);
+
+	ws::frame_writer<char> empty(ws::opcode::close, std::span<const char>());
+	auto f = empty.next();
+	BOOST_TEST_REQUIRE(f.has_value());
+	BOOST_TEST(f->size() == 1);
+	BOOST_TEST(f->total_size() == 2);
+	BOOST_TEST(!empty.next().has_value());
+	BOOST_CHECK_THROW(ws::frame_writer<char>(ws::opcode::ping, std::span<const char>(std::string(126, 'a'))), std::out_of_range);
+}
+BOOST_AUTO_TEST_SUITE_END() // frames
+
+BOOST_AUTO_TEST_SUITE(acceptor)
+using parser_t = http_parser::pmr_str::http1_req_parser<>;
+struct frame_handler {
+	std::vector<std::string> messages;
+	std::string cur;
+	std::uint16_t error = 0;
+	void on_frame(const ws::frame_header& fh, std::span<char> payload, bool end) {
+		cur.append(payload.data(), payload.size());
+		if(end && fh.fin && !ws::is_control(fh.op)) messages.push_back(std::exchange(cur, std::string{}));
+	}
+	void on_frame_error(std::uint16_t code) { error = code; }
+};
+struct factory {
+	frame_handler operator()(const parser_t::message_t&) { return frame_handler{}; }
+};
+BOOST_AUTO_TEST_CASE(decode)
+{
+	http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, factory> acc(factory{});
+	parser_t prs(&acc);
+	auto frame = masked_frame(0x81, "Hello");
+	prs("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n"s + frame.substr(0, 1));
+	prs(frame.substr(1, 6));
+	prs(frame.substr(7) + masked_frame(0x81, "second"));
+	BOOST_TEST_REQUIRE(acc.handlers.size() == 1);
+	auto& hndl = *acc.handlers.begin()->second.hndl;
+	BOOST_TEST_REQUIRE(hndl.messages.size() == 2);
+	BOOST_TEST(hndl.messages[0] == "Hello");
+	BOOST_TEST(hndl.messages[1] == "second");
+
+	const auto cached = prs.cached_size();
+	for(int i=0;i<100;++i) prs(masked_frame(0x81, "message"));
+	const auto split = masked_frame(0x81, "split");
+	prs(split.substr(0, 8));
+	BOOST_TEST(prs.cached_size() == cached);
+	BOOST_TEST(hndl.messages.size() == 102);
+	prs(split.substr(8));
+	BOOST_TEST(prs.cached_size() == cached);
+	BOOST_TEST_REQUIRE(hndl.messages.size() == 103);
+	BOOST_TEST(hndl.messages.back() == "split");
+
+	prs(masked_frame(0x80, "bad"));
+	BOOST_TEST(hndl.error == ws::close_codes::protocol_error);
+
+	acc.utf8_validation(true);
+	parser_t checked(&acc);
+	checked("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n"s + masked_frame(0x81, "\xff"s));
+	BOOST_TEST_REQUIRE(acc.handlers.size() == 2);
+	for(auto& s:acc.handlers) if(&s.second.hndl.value() != &hndl)
+		BOOST_TEST(s.second.hndl->error == ws::close_codes::invalid_payload);
+}
+BOOST_AUTO_TEST_CASE(idle_eviction)
+{
+	http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, factory> acc(factory{});
+	acc.idle_timeout(10s);
+	auto start = std::chrono::steady_clock::now();
+	parser_t active(&acc), idle(&acc);
+	auto upgrade = "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n"s;
+	active(upgrade + masked_frame(0x81, "a"));
+	idle(upgrade + masked_frame(0x81, "a"));
+	BOOST_TEST(acc.handlers.size() == 2);
+
+	BOOST_TEST(acc.expire(start + 6s) == 0);
+	active(masked_frame(0x81, "b"));
+	BOOST_TEST(acc.expire(start + 12s) == 1);
+	BOOST_TEST(acc.handlers.size() == 1);
+	BOOST_TEST(acc.handlers.begin()->second.hndl->messages.size() == 2);
+	BOOST_TEST(acc.expire(start + 30s) == 1);
+	BOOST_TEST(acc.handlers.size() == 0);
+}
+BOOST_AUTO_TEST_CASE(selected_by_chain)
+{
+	using ws_t = http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, factory>;
+	struct checked_ws : ws_t {
+		std::size_t checks = 0;
+		checked_ws() : ws_t(factory{}) {}
+		bool can_accept(const parser_t::message_t& head) override { ++checks; return ws_t::can_accept(head); }
+	};
+	auto acc = std::make_shared<checked_ws>();
+	parser_t::chain_acceptor_type chain;
+	chain.add(acc);
+	parser_t prs(&chain);
+	prs("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n"s + masked_frame(0x81, "a"));
+	prs(masked_frame(0x81, "b"));
+	BOOST_TEST(acc->checks == 0);
+	BOOST_TEST_REQUIRE(acc->handlers.size() == 1);
+	BOOST_TEST(acc->handlers.begin()->second.hndl->messages.size() == 2);
+}
+BOOST_AUTO_TEST_CASE(mixed_case_upgrade)
+{
+	using ws_t = http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, factory>;
+	const auto upgrade = "GET / HTTP/1.1\r\nUpgrade: WebSocket\r\nConnection: Upgrade\r\n\r\n"s;
+
+	ws_t acc(factory{});
+	parser_t direct(&acc);
+	direct(upgrade + masked_frame(0x81, "a"));
+	direct(masked_frame(0x81, "b"));
+	BOOST_TEST_REQUIRE(acc.handlers.size() == 1);
+	BOOST_TEST(acc.handlers.begin()->second.hndl->messages.size() == 2);
+	BOOST_TEST(direct.cached_size() == upgrade.size());
+
+	auto chained_acc = std::make_shared<ws_t>(factory{});
+	parser_t::chain_acceptor_type chain;
+	chain.add(chained_acc);
+	parser_t chained(&chain);
+	chained(upgrade + masked_frame(0x81, "c"));
+	BOOST_TEST_REQUIRE(chained_acc->handlers.size() == 1);
+	BOOST_TEST(chained_acc->handlers.begin()->second.hndl->messages.size() == 1);
+
+	parser_t closed(&acc);
+	acc.for_connection(3, [&]{ closed(upgrade); });
+	BOOST_TEST(acc.close_connection(3));
+	acc.for_connection(3, [&]{ closed(masked_frame(0x81, "lost")); });
+	BOOST_TEST(closed.cached_size() == upgrade.size());
+}
+BOOST_AUTO_TEST_CASE(connection_reuse)
+{
+	http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, factory> acc(factory{});
+	auto upgrade = "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n"s;
+	{
+		parser_t prs(&acc);
+		acc.for_connection(7, [&]{ prs(upgrade + masked_frame(0x80, "bad")); });
+	}
+	BOOST_TEST_REQUIRE(acc.handlers.find(7) != nullptr);
+	BOOST_TEST(acc.handlers.find(7)->hndl->error == ws::close_codes::protocol_error);
+
+	parser_t prs(&acc);
+	acc.for_connection(7, [&]{ prs(upgrade + masked_frame(0x81, "fresh")); });
+	BOOST_TEST_REQUIRE(acc.handlers.size() == 1);
+	auto& hndl = *acc.handlers.find(7)->hndl;
+	BOOST_TEST(hndl.error == 0);
+	BOOST_TEST_REQUIRE(hndl.messages.size() == 1);
+	BOOST_TEST(hndl.messages[0] == "fresh");
+
+	BOOST_TEST(acc.close_connection(7));
+	BOOST_TEST(acc.handlers.size() == 0);
+}
+BOOST_AUTO_TEST_SUITE_END() // acceptor
+
+BOOST_AUTO_TEST_SUITE(handshake)
+using parser_t = http_parser::pmr_str::http1_req_parser<>;
+
+struct counting_resource : std::pmr::memory_resource {
+	std::size_t count = 0;
+	void* do_allocate(std::size_t bytes, std::size_t align) override
+	{ ++count; return std::pmr::new_delete_resource()->allocate(bytes, align); }
+	void do_deallocate(void* p, std::size_t bytes, std::size_t align) override
+	{ std::pmr::new_delete_resource()->deallocate(p, bytes, align); }
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+struct response_writer {
+	std::string* last;
+	bool* accepted;
+	void operator()(const parser_t::message_t&, std::span<const char> resp, bool ok) {
+		last->assign(resp.data(), resp.size());
+		*accepted = ok;
+	}
+};
+using generator_t = http_parser::basic_generator<http_parser::pmr_string_factory, std::string_view>;
+using acceptor_t = http_parser::http1_ws_acceptor<parser_t::message_t, parser_t::data_container_t, response_writer, generator_t>;
+
+const auto request = "GET /chat HTTP/1.1\r\nHost: server.example.com\r\nUpgrade: websocket\r\n"
+                     "Connection: keep-alive, Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n\r\n"s;
+
+BOOST_AUTO_TEST_CASE(accept_key)
+{
+	static_assert(ws::make_accept_key("dGhlIHNhbXBsZSBub25jZQ==").view() == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="sv);
+	BOOST_TEST(ws::valid_client_key("dGhlIHNhbXBsZSBub25jZQ=="));
+	BOOST_TEST(!ws::valid_client_key("dGhlIHNhbXBsZSBub25jZQ="));
+	BOOST_TEST(!ws::valid_client_key("dGhlIHNhbXBsZSBub25jZQ=a"));
+}
+BOOST_AUTO_TEST_CASE(response)
+{
+	std::string last;
+	bool accepted = false;
+	acceptor_t acc(response_writer{&last, &accepted});
+	parser_t prs(&acc);
+	prs(request);
+	BOOST_TEST(accepted);
+	BOOST_TEST(last == "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+	                   "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n");
+
+	parser_t bad_version(&acc);
+	auto req = request;
+	req.replace(req.find("13\r\n"), 2, "8");
+	bad_version(req);
+	BOOST_TEST(!accepted);
+	BOOST_TEST(last.starts_with("HTTP/1.1 426 "));
+	BOOST_TEST(last.find("Sec-WebSocket-Version: 13\r\n") != std::string::npos);
+	BOOST_TEST(last.ends_with("Content-Length: 0\r\nConnection: close\r\n\r\n"));
+
+	parser_t bad_key(&acc);
+	req = request;
+	req.replace(req.find("dGhl"), 4, "");
+	bad_key(req);
+	BOOST_TEST(!accepted);
+	BOOST_TEST(last.starts_with("HTTP/1.1 400 "));
+	BOOST_TEST(last.ends_with("\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+
+	parser_t bad_name(&acc);
+	req = request;
+	req.replace(req.find("Host"), 4, "H\xc3\xb6st");
+	bad_name(req);
+	BOOST_TEST(!accepted);
+	BOOST_TEST(last.starts_with("HTTP/1.1 400 "));
+
+	parser_t post(&acc);
+	req = request;
+	req.replace(0, 3, "PUT");
+	post(req);
+	BOOST_TEST(!accepted);
+}
+BOOST_AUTO_TEST_CASE(frames)
+{
+	using frames_t = http_parser::acceptors::ws<parser_t::message_t, parser_t::data_container_t, acceptor::factory>;
+	frames_t frames(acceptor::factory{});
+	std::string last;
+	bool accepted = false;
+	parser_t::chain_acceptor_type chain;
+	chain.add(acceptor_t(response_writer{&last, &accepted}, &frames));
+	const auto& upgrade = request;
+
+	parser_t rejected(&chain);
+	auto req = upgrade;
+	req.replace(req.find("13\r\n"), 2, "8");
+	rejected(req + masked_frame(0x81, "lost"));
+	BOOST_TEST(!accepted);
+	BOOST_TEST(frames.handlers.size() == 0);
+	BOOST_TEST(rejected.cached_size() == req.size());
+
+	parser_t prs(&chain);
+	prs(upgrade + masked_frame(0x81, "Hello"));
+	BOOST_TEST(accepted);
+	prs(masked_frame(0x81, "world"));
+	BOOST_TEST_REQUIRE(frames.handlers.size() == 1);
+	auto& hndl = *frames.handlers.begin()->second.hndl;
+	BOOST_TEST_REQUIRE(hndl.messages.size() == 2);
+	BOOST_TEST(hndl.messages[0] == "Hello");
+	BOOST_TEST(hndl.messages[1] == "world");
+	BOOST_TEST(prs.cached_size() == upgrade.size());
+}
+BOOST_AUTO_TEST_CASE(no_allocations)
+{
+	counting_resource mem;
+	std::string last;
+	bool accepted = false;
+	acceptor_t acc(response_writer{&last, &accepted}, generator_t(http_parser::pmr_string_factory{&mem}));
+	parser_t prs(&acc);
+	prs(request);
+	BOOST_TEST(accepted);
+	const auto after_first = mem.count;
+	for(int i=0;i<100;++i) {
+		accepted = false;
+		parser_t next(&acc);
+		next(request);
+		BOOST_TEST_REQUIRE(accepted);
+	}
+	BOOST_TEST(mem.count == after_first);
+}
+BOOST_AUTO_TEST_CASE(storm, * utf::label("speed") * utf::enable_if<enable_speed_tests>())
+{
+	std::string last;
+	bool accepted = false;
+	acceptor_t acc(response_writer{&last, &accepted});
+	auto start = std::chrono::high_resolution_clock::now();
+	for(int i=0;i<50000;++i) {
+		parser_t prs(&acc);
+		prs(request);
+	}
+	auto dur = std::chrono::high_resolution_clock::now() - start;
+	BOOST_TEST(accepted);
+	BOOST_TEST(std::chrono::duration_cast<std::chrono::milliseconds>(dur).count() < 1000);
+}
+BOOST_AUTO_TEST_SUITE_END() // handshake
+BOOST_AUTO_TEST_SUITE_END() // websocket